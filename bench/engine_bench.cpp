@@ -0,0 +1,211 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "median_degree_engine.h"
+#include "synthetic_stream.h"
+
+
+/*------------------------------------------------------------------------------
+  Graph and window stages, and the whole per-line pipeline, over synthetic
+  streams. Every benchmark takes the stream shape as arguments: users, skew
+  (in hundredths) and out-of-order percentage; see synthetic_stream.h.
+
+  The per-stage benchmarks run against a warmed-up, full 60 second window.
+  They time one second's worth of payments at a time (1000 of them), and do
+  the other half of the work untimed: adding the next second's payments
+  when timing the purge, and purging when timing the adds. Payments keep
+  how far behind the stream they were generated, so out-of-order ones
+  still land in older ticks.
+  ------------------------------------------------------------------------------*/
+
+namespace {
+
+  struct warmEngine
+  {
+    connection_set cs;
+    degree_index degrees;
+    userInterner users;
+    std::vector<payment> stream;
+    // by payment, how many ticks it is behind the newest one before it
+    std::vector<timestamp> lag;
+    std::size_t next;
+
+    explicit warmEngine(const benchmark::State& state)
+      : next(0)
+    {
+      paymentStreamConfig config = syntheticStreamArgs(state.range(0), state.range(1), state.range(2));
+      config.events = 200 * config.eventsPerSecond;
+      stream = generatePayments(config);
+      // the graph functions take times in window ticks
+      for (std::vector<payment>::iterator p = stream.begin(); p != stream.end(); ++p) {
+	p->time = cs.window.tickOf(p->time);
+      }
+      timestamp newest = stream.empty() ? 0 : stream.front().time;
+      lag.reserve(stream.size());
+      for (std::vector<payment>::const_iterator p = stream.begin(); p != stream.end(); ++p) {
+	newest = std::max(newest, p->time);
+	lag.push_back(newest - p->time);
+      }
+      // fill the window, so expiry is already in steady state
+      while (next < 60 * config.eventsPerSecond) {
+	addOrUpdateConnections(stream[next++], cs, degrees, users);
+      }
+    }
+
+    // the next payment, moved into the window's current second, or as
+    // far behind it as it was generated
+    payment nextAtHead()
+    {
+      if (next == stream.size())
+	next = 0;
+      payment p = stream[next];
+      p.time = cs.edges.newest() - lag[next++];
+      return p;
+    }
+  };
+
+  void streamArgs(benchmark::internal::Benchmark* b)
+  {
+    b->ArgNames({"users", "skew%", "ooo%"});
+    b->ArgsProduct({{1000, 100000}, {0, 120}, {0, 20}});
+  }
+
+  const std::size_t PAYMENTS_PER_SECOND = 1000;
+
+}
+
+static void BM_AddOrUpdateConnections(benchmark::State& state)
+{
+  warmEngine engine(state);
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < PAYMENTS_PER_SECOND; i++) {
+      addOrUpdateConnections(engine.nextAtHead(), engine.cs, engine.degrees, engine.users);
+    }
+    state.PauseTiming();
+    purgePaymentWindow(engine.cs.edges.newest() + 1, engine.cs, engine.degrees, engine.users);
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * PAYMENTS_PER_SECOND);
+}
+BENCHMARK(BM_AddOrUpdateConnections)->Apply(streamArgs);
+
+static void BM_PurgePaymentWindow(benchmark::State& state)
+{
+  warmEngine engine(state);
+  for (auto _ : state) {
+    purgePaymentWindow(engine.cs.edges.newest() + 1, engine.cs, engine.degrees, engine.users);
+    state.PauseTiming();
+    for (std::size_t i = 0; i < PAYMENTS_PER_SECOND; i++) {
+      addOrUpdateConnections(engine.nextAtHead(), engine.cs, engine.degrees, engine.users);
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * PAYMENTS_PER_SECOND);
+}
+BENCHMARK(BM_PurgePaymentWindow)->Apply(streamArgs);
+
+static void BM_PrintRank(benchmark::State& state)
+{
+  warmEngine engine(state);
+  std::ofstream devNull("/dev/null", std::ofstream::binary);
+  medianWriter results(devNull);
+  for (auto _ : state) {
+    printRank(engine.cs, engine.degrees, results, engine.users);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PrintRank)->Apply(streamArgs);
+
+// parse, validate, intern, update and print: what main() does per line
+static void BM_EndToEnd(benchmark::State& state)
+{
+  paymentStreamConfig config = syntheticStreamArgs(state.range(0), state.range(1), state.range(2));
+  config.events = 200000;
+  std::vector<std::string> lines = generateLines(config);
+  std::ofstream devNull("/dev/null", std::ofstream::binary);
+
+  for (auto _ : state) {
+    medianDegreeEngine engine;
+    medianWriter results(devNull);
+    std::size_t twiceMedian;
+
+    for (std::vector<std::string>::const_iterator line = lines.begin(); line != lines.end(); ++line) {
+      if (engine.pushLine(*line, twiceMedian))
+	results.write(twiceMedian);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * lines.size());
+}
+BENCHMARK(BM_EndToEnd)->Apply(streamArgs)->Unit(benchmark::kMillisecond);
+
+// the same, as main() runs it on files: parsed, then pushed 4096 at a time
+static void BM_EndToEndBatched(benchmark::State& state)
+{
+  paymentStreamConfig config = syntheticStreamArgs(state.range(0), state.range(1), state.range(2));
+  config.events = 200000;
+  std::vector<std::string> lines = generateLines(config);
+  std::ofstream devNull("/dev/null", std::ofstream::binary);
+  const std::size_t batchSize = 4096;
+
+  for (auto _ : state) {
+    medianDegreeEngine engine;
+    medianWriter results(devNull);
+    std::vector<payment> batch;
+    std::vector<std::size_t> twiceMedians(batchSize);
+    payment p;
+
+    for (std::size_t i = 0; i < lines.size(); i++) {
+      if (engine.parseLine(lines[i], p))
+	batch.push_back(p);
+      if (batch.size() == batchSize || (i + 1 == lines.size() && !batch.empty())) {
+	engine.pushBatch(batch.data(), batch.size(), twiceMedians.data());
+	for (std::size_t j = 0; j < batch.size(); j++) {
+	  results.write(twiceMedians[j]);
+	}
+	batch.clear();
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * lines.size());
+}
+BENCHMARK(BM_EndToEndBatched)->Apply(streamArgs)->Unit(benchmark::kMillisecond);
+
+// the same, keeping 10 second, 60 second and 5 minute windows in one engine
+static void BM_EndToEndNested(benchmark::State& state)
+{
+  paymentStreamConfig config = syntheticStreamArgs(state.range(0), state.range(1), state.range(2));
+  config.events = 200000;
+  std::vector<std::string> lines = generateLines(config);
+  std::ofstream devNull("/dev/null", std::ofstream::binary);
+  const std::size_t batchSize = 4096;
+  std::vector<windowConfig> windows;
+  windows.push_back(windowConfig(10 * MILLISECONDS_PER_SECOND));
+  windows.push_back(windowConfig(60 * MILLISECONDS_PER_SECOND));
+  windows.push_back(windowConfig(300 * MILLISECONDS_PER_SECOND));
+
+  for (auto _ : state) {
+    medianDegreeEngine engine(windows);
+    medianWriter results(devNull);
+    std::vector<payment> batch;
+    std::vector<std::size_t> twiceMedians(batchSize * windows.size());
+    payment p;
+
+    for (std::size_t i = 0; i < lines.size(); i++) {
+      if (engine.parseLine(lines[i], p))
+	batch.push_back(p);
+      if (batch.size() == batchSize || (i + 1 == lines.size() && !batch.empty())) {
+	engine.pushBatch(batch.data(), batch.size(), twiceMedians.data());
+	for (std::size_t j = 0; j < batch.size(); j++) {
+	  results.writeRow(&twiceMedians[j * windows.size()], windows.size());
+	}
+	batch.clear();
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * lines.size());
+}
+BENCHMARK(BM_EndToEndNested)->Apply(streamArgs)->Unit(benchmark::kMillisecond);
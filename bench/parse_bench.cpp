@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+
+#include <boost/algorithm/string.hpp>
+
+#include <string>
+#include <vector>
+
+#include "payment_parser.h"
+#include "synthetic_stream.h"
+
+
+/*------------------------------------------------------------------------------
+  Line parsing: paymentParser against the Json::Reader + asString() path it
+  replaced, on the same lines.
+  ------------------------------------------------------------------------------*/
+
+static std::vector<std::string> benchLines()
+{
+  paymentStreamConfig config = syntheticStreamArgs(10000, 0, 0);
+  config.events = 4096;
+  return generateLines(config);
+}
+
+static void BM_ParsePaymentLine(benchmark::State& state)
+{
+  std::vector<std::string> lines = benchLines();
+  paymentParser parser;
+  paymentFields fields;
+  std::size_t i = 0, bytes = 0;
+  for (auto _ : state) {
+    const std::string& line = lines[i++ & 4095];
+    benchmark::DoNotOptimize(parser.parse(line, fields));
+    benchmark::DoNotOptimize(fields);
+    bytes += line.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_ParsePaymentLine);
+
+static void BM_ParseJsonReader(benchmark::State& state)
+{
+  std::vector<std::string> lines = benchLines();
+  Json::Reader jsonReader;
+  Json::Value root;
+  std::size_t i = 0, bytes = 0;
+  for (auto _ : state) {
+    const std::string& line = lines[i++ & 4095];
+    jsonReader.parse(line, root, false);
+    std::string actor = root["actor"].asString(), target = root["target"].asString();
+    benchmark::DoNotOptimize(boost::trim_copy(actor) == boost::trim_copy(target));
+    benchmark::DoNotOptimize(root["created_time"].asString());
+    bytes += line.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_ParseJsonReader);
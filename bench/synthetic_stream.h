@@ -0,0 +1,21 @@
+#ifndef SYNTHETIC_STREAM_H
+#define SYNTHETIC_STREAM_H
+
+#include "payment_stream_generator.h"
+
+
+// Benchmark args are integers: users, skew in hundredths, out-of-order
+// percent. The streams have no late or invalid lines, so every payment
+// reaches the engine; see payment_stream_generator.h for the rest.
+inline paymentStreamConfig syntheticStreamArgs(long users, long skewPercent, long outOfOrderPercent)
+{
+  paymentStreamConfig config;
+  config.users = static_cast<user_id>(users);
+  config.skew = skewPercent / 100.0;
+  config.outOfOrder = outOfOrderPercent / 100.0;
+  config.late = 0;
+  config.invalid = 0;
+  return config;
+}
+
+#endif
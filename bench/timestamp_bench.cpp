@@ -0,0 +1,53 @@
+#include <benchmark/benchmark.h>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "timestamp.h"
+
+
+/*------------------------------------------------------------------------------
+  created_time decoding: the fixed-format parser against the
+  stringstream/time_input_facet path it replaced.
+  ------------------------------------------------------------------------------*/
+
+static std::vector<std::string> sampleTimestamps()
+{
+  std::vector<std::string> samples;
+  for (timestamp t = 1459999999 * MILLISECONDS_PER_SECOND; samples.size() < 4096; t += 7 * MILLISECONDS_PER_SECOND) {
+    samples.push_back(formatTimestamp(t));
+  }
+  return samples;
+}
+
+static void BM_TimestampFixedFormat(benchmark::State& state)
+{
+  std::vector<std::string> samples = sampleTimestamps();
+  std::size_t i = 0;
+  timestamp t;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(parseTimestamp(samples[i++ & 4095], t));
+    benchmark::DoNotOptimize(t);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimestampFixedFormat);
+
+static void BM_TimestampFacet(benchmark::State& state)
+{
+  std::vector<std::string> samples = sampleTimestamps();
+  std::locale localeWithFacet(std::locale(""), new boost::posix_time::time_input_facet("%Y-%m-%dT%H:%M:%SZ"));
+  std::size_t i = 0;
+  for (auto _ : state) {
+    boost::posix_time::ptime time;
+    std::stringstream ss(samples[i++ & 4095]);
+    ss.imbue(localeWithFacet);
+    ss >> time;
+    benchmark::DoNotOptimize(time);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimestampFacet);
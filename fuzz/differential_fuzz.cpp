@@ -0,0 +1,524 @@
+#include <boost/cstdint.hpp>
+#include <boost/format.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ingest_pipeline.h"
+#include "line_reader.h"
+#include "median_degree_engine.h"
+#include "naive_engine.h"
+#include "reorder_buffer.h"
+#include "verbose_output.h"
+
+
+/*------------------------------------------------------------------------------
+  Differential fuzzing: MedianDegreeEngine against the naive solution.
+
+  Both engines get the same lines, and have to agree on every one of them:
+  whether it's a valid payment, and if so, the median after it. The first
+  line they disagree on fails the run. MedianDegreeEngine goes through the
+  stream twice, a line at a time and as a single pushBatch, and both have
+  to match, down to the state they publish. Put back in order by a reorder buffer, the stream's
+  payments also have to give the same medians through pushInOrder as
+  through pushBatch. The ingest pipeline's output has to match too, while
+  another thread polls its engine's published state.
+
+  Streams are decoded from bytes, four per line (actor, target, time step,
+  line kind and fraction), after a header byte picking the user population.
+  Time steps are relative to the newest payment so far and lean on the
+  edges of the window: payments exactly 59, 60 and 61 seconds late or
+  early, some a millisecond either side of the second. Line kinds add
+  exact duplicates, reflexive payments, padded and escaped names, and lines
+  either engine has to reject, among them created_times with an overlong
+  field, a day past the end of its month or a malformed fraction.
+
+  Besides the default window, every stream also goes through both engines
+  with a 10 second window at half-second granularity, and through one
+  engine keeping three windows at once, which has to give each window's
+  medians just as an engine of its own would.
+
+  The same bytes also drive degreeHistogram and the ranked index through
+  user degrees spread far apart, up to hundreds of thousands, where the
+  histogram's buckets are mostly empty; their medians have to agree after
+  every change.
+
+  Built with -DMEDIAN_LIBFUZZER, this is a libFuzzer target. Otherwise it's a
+  standalone driver feeding the decoder random bytes, run by ctest; it can
+  also compare the engines on existing input files.
+  ------------------------------------------------------------------------------*/
+
+namespace {
+
+  // 2016-04-07T03:33:19Z, the first timestamp in the challenge example
+  const timestamp FUZZ_STREAM_START = 1459999999 * MILLISECONDS_PER_SECOND;
+
+  const int TIME_STEPS[] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    2, -1, -2, -10, -30, -58, -59, -60, -61, 58, 59, 60, 61, 120, 3, -5
+  };
+  const std::size_t TIME_STEP_COUNT = sizeof(TIME_STEPS) / sizeof(TIME_STEPS[0]);
+
+  // milliseconds added to a step, by the line kind byte's high bits
+  const int TIME_FRACTIONS[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 500, 999, -1};
+
+  std::string paymentLine(const std::string& actor, const std::string& target, const std::string& time)
+  {
+    return "{\"created_time\": \"" + time + "\", \"target\": \"" + target + "\", \"actor\": \"" + actor + "\"}";
+  }
+
+  std::vector<std::string> decodeStream(const boost::uint8_t* data, std::size_t size)
+  {
+    std::vector<std::string> lines;
+    if (size == 0)
+      return lines;
+    unsigned users = 2 + data[0] % 31;
+
+    timestamp newest = FUZZ_STREAM_START;
+    for (std::size_t i = 1; i + 4 <= size; i += 4) {
+      timestamp time = newest + TIME_STEPS[data[i + 2] % TIME_STEP_COUNT] * MILLISECONDS_PER_SECOND + TIME_FRACTIONS[data[i + 3] >> 4];
+      newest = std::max(newest, time);
+      std::string actor = "user-" + std::to_string(data[i] % users);
+      std::string target = "user-" + std::to_string(data[i + 1] % users);
+      std::string created = formatTimestamp(time);
+
+      switch (data[i + 3] % 16) {
+      case 0:
+	// an exact repeat of the previous line
+	lines.push_back(lines.empty() ? paymentLine(actor, target, created) : lines.back());
+	break;
+      case 1:
+	lines.push_back(paymentLine(actor, actor, created));
+	break;
+      case 2:
+	// validated trimmed, but the padded name is a user of its own
+	lines.push_back(paymentLine(" " + actor, target, created));
+	break;
+      case 3:
+	// the same user as the unescaped name
+	lines.push_back(paymentLine("user-\\u00" + std::to_string(30 + data[i] % 10), target, created));
+	break;
+      case 4:
+	lines.push_back("{\"target\": \"" + target + "\", \"actor\": \"" + actor + "\"}");
+	break;
+      case 5:
+	lines.push_back(paymentLine(actor, "  ", created));
+	break;
+      case 6:
+	// a created_time that's nearly right
+	switch (data[i] % 8) {
+	case 0:
+	  created.replace(5, 2, "13");
+	  break;
+	case 1:
+	  // a day that rolls over into the next month
+	  created.replace(5, 5, data[i] & 8 ? "02-30" : "04-31");
+	  break;
+	case 2:
+	  created.replace(11, 2, "24");
+	  break;
+	case 3:
+	  // an overlong field
+	  created.insert(data[i] & 8 ? 10 : 19, "888");
+	  break;
+	case 4:
+	  created = created.substr(0, 19) + ".Z";
+	  break;
+	case 5:
+	  created = created.substr(0, 19) + ".1234567890Z";
+	  break;
+	case 6:
+	  created = created.substr(0, 19) + ".12aZ";
+	  break;
+	default:
+	  // valid: nine digits of fraction, all but the millisecond ignored
+	  created = created.substr(0, created.size() - 1) + (created.size() == 20 ? ".000" : "") + "999999Z";
+	  break;
+	}
+	lines.push_back(paymentLine(actor, target, created));
+	break;
+      case 7:
+	lines.push_back(paymentLine(actor, target, created).substr(0, 20 + data[i] % 40));
+	break;
+      default:
+	lines.push_back(paymentLine(actor, target, created));
+	break;
+      }
+    }
+    return lines;
+  }
+
+
+  std::string describeResult(bool valid, std::size_t twiceMedian)
+  {
+    return valid ? (boost::format("%1%") % (twiceMedian / 2.0)).str() : "rejected";
+  }
+
+  // A snapshot that could have been published: no fewer payments than
+  // the last one, and no more users than the edges can connect.
+  bool plausibleSnapshot(const medianSnapshot& snapshot, boost::uint64_t lastPayments)
+  {
+    return snapshot.payments >= lastPayments && snapshot.users <= 2 * snapshot.edges &&
+      (snapshot.users > 0 || snapshot.twiceMedian == 0);
+  }
+
+  // the stream through the ingest pipeline, in chunks small enough that
+  // every parser thread gets several, with a reader polling the engine's
+  // published state all along; polled is false if it ever looked torn
+  std::string pipelineOutput(const std::vector<std::string>& lines, bool& polled)
+  {
+    std::string text;
+    for (std::vector<std::string>::const_iterator line = lines.begin(); line != lines.end(); ++line) {
+      text += *line + '\n';
+    }
+    std::istringstream in(text);
+    streamLineReader reader(in);
+    std::ostringstream out;
+    {
+      medianDegreeEngine engine;
+      medianWriter results(out);
+      std::atomic<bool> done(false);
+      polled = true;
+      std::thread poller([&] {
+	  boost::uint64_t lastPayments = 0;
+	  while (!done.load()) {
+	    medianSnapshot snapshot = engine.published().read();
+	    polled = polled && plausibleSnapshot(snapshot, lastPayments);
+	    lastPayments = snapshot.payments;
+	    std::this_thread::yield();
+	  }
+	});
+      runIngestPipeline(reader, engine, results, 3, 7);
+      done.store(true);
+      poller.join();
+    }
+    return out.str();
+  }
+
+  // The payments through a reorder buffer and pushInOrder, the way
+  // --max-lateness takes them, against pushBatch on the order they came
+  // out in. False if they disagree.
+  bool reorderedMatch(const std::vector<payment>& payments, timestamp lateness)
+  {
+    reorderBuffer reorder(lateness);
+    medianDegreeEngine inOrder;
+    std::vector<payment> released, sequence;
+    std::vector<std::size_t> medians;
+    auto pushReleased = [&] {
+      std::size_t done = medians.size();
+      medians.resize(done + released.size());
+      inOrder.pushInOrder(released.data(), released.size(), medians.data() + done);
+      sequence.insert(sequence.end(), released.begin(), released.end());
+      released.clear();
+    };
+    for (std::vector<payment>::const_iterator p = payments.begin(); p != payments.end(); ++p) {
+      if (!reorder.push(*p, released)) {
+	pushReleased();
+	medians.push_back(0);
+	inOrder.pushBatch(&*p, 1, &medians.back());
+	sequence.push_back(*p);
+      }
+      pushReleased();
+    }
+    reorder.flush(released);
+    pushReleased();
+
+    medianDegreeEngine reference;
+    std::vector<std::size_t> expected(sequence.size());
+    reference.pushBatch(sequence.data(), sequence.size(), expected.data());
+    return sequence.size() == payments.size() && medians == expected;
+  }
+
+  // The lines through both engines with a window of `length` at
+  // `granularity`, given in milliseconds. False, with the diverging line in
+  // `report`, if they disagree.
+  bool windowedMatch(const std::vector<std::string>& lines, timestamp length, timestamp granularity, std::string& report)
+  {
+    medianDegreeEngine fast(windowConfig(length, granularity));
+    naive::engine oracle((boost::posix_time::milliseconds(length)), boost::posix_time::milliseconds(granularity));
+    for (std::size_t i = 0; i < lines.size(); i++) {
+      std::size_t fastMedian = 0, naiveMedian = 0;
+      bool fastValid = fast.pushLine(lines[i], fastMedian);
+      bool naiveValid = oracle.processLine(lines[i], naiveMedian);
+      if (fastValid != naiveValid || (fastValid && fastMedian != naiveMedian)) {
+	report = (boost::format("%1%ms window at %2%ms, line %3%: %4%\n  MedianDegreeEngine: %5%\n  naive: %6%\n")
+		  % length % granularity % (i + 1) % lines[i] % describeResult(fastValid, fastMedian)
+		  % describeResult(naiveValid, naiveMedian)).str();
+	return false;
+      }
+    }
+    return true;
+  }
+
+  // The payments through one engine keeping several windows, in batches
+  // small enough that window state carries across them, against an engine
+  // per window. False, with the first payment they disagree on in
+  // `report`, if they do.
+  bool nestedMatch(const std::vector<payment>& payments, std::string& report)
+  {
+    const std::size_t BATCH = 7;
+    std::vector<windowConfig> windows;
+    windows.push_back(windowConfig(10000, 500));
+    windows.push_back(windowConfig(60000, 500));
+    windows.push_back(windowConfig(2500, 500));
+    medianDegreeEngine nested(windows);
+    std::vector<std::size_t> rows(payments.size() * windows.size());
+    for (std::size_t i = 0; i < payments.size(); i += BATCH) {
+      nested.pushBatch(payments.data() + i, std::min(BATCH, payments.size() - i), rows.data() + i * windows.size());
+    }
+    // and a payment at a time, which only returns the first window's
+    medianDegreeEngine nestedSingly(windows);
+    for (std::size_t i = 0; i < payments.size(); i++) {
+      std::size_t twiceMedian = nestedSingly.push(payments[i]);
+      if (twiceMedian != rows[i * windows.size()] || nestedSingly.twiceMedian(2) != rows[i * windows.size() + 2]) {
+	report = (boost::format("payment %1%: nested windows give different medians through push() and pushBatch()\n") % (i + 1)).str();
+	return false;
+      }
+    }
+
+    for (std::size_t w = 0; w < windows.size(); w++) {
+      medianDegreeEngine single(windows[w]);
+      std::vector<std::size_t> medians(payments.size());
+      single.pushBatch(payments.data(), payments.size(), medians.data());
+      for (std::size_t i = 0; i < payments.size(); i++) {
+	if (rows[i * windows.size() + w] != medians[i]) {
+	  report = (boost::format("payment %1%, window %2%ms: nested windows give %3%, a window of its own %4%\n")
+		    % (i + 1) % windows[w].length % describeResult(true, rows[i * windows.size() + w])
+		    % describeResult(true, medians[i])).str();
+	  return false;
+	}
+      }
+      if (w == 0) {
+	medianSnapshot nestedLast = nested.published().read(), singleLast = single.published().read();
+	if (nestedLast.payments != singleLast.payments || nestedLast.users != singleLast.users ||
+	    nestedLast.edges != singleLast.edges || nestedLast.newest != singleLast.newest) {
+	  report = "nested windows end with a different published state than their first window alone\n";
+	  return false;
+	}
+      }
+    }
+    return true;
+  }
+
+  // false, with the diverging line in `report`, if the engines disagree
+  // Two bytes per change: a user, and the degree it moves to.
+  bool histogramMatch(const boost::uint8_t* data, std::size_t size, std::string& report)
+  {
+    const std::size_t DEGREES[] = {0, 0, 1, 1, 2, 3, 5, 63, 64, 65, 1000, 4095, 4096, 4097, 70000, 300000};
+    const std::size_t USERS = 16;
+    std::vector<std::size_t> degrees(USERS, 0);
+    degreeHistogram histogram;
+    rankedDegreeIndex ranked;
+    for (std::size_t i = 0; i + 1 < size; i += 2) {
+      std::size_t& degree = degrees[data[i] % USERS];
+      std::size_t to = DEGREES[data[i + 1] % (sizeof(DEGREES) / sizeof(DEGREES[0]))];
+      histogram.change(degree, to);
+      ranked.change(degree, to);
+      degree = to;
+      if (histogram.size() != ranked.size() || histogram.twiceMedian() != ranked.twiceMedian()) {
+	report = (boost::format("change %1%: degree histogram has %2% users, median %3%; ranked index %4%, %5%\n")
+		  % (i / 2 + 1) % histogram.size() % histogram.median() % ranked.size() % ranked.median()).str();
+	return false;
+      }
+    }
+    return true;
+  }
+
+  bool compareEngines(const std::vector<std::string>& lines, std::string& report)
+  {
+    // the whole stream through pushBatch too, which has to match push()
+    medianDegreeEngine batched;
+    std::vector<payment> payments;
+    std::vector<bool> batchValid(lines.size());
+    for (std::size_t i = 0; i < lines.size(); i++) {
+      payment p;
+      batchValid[i] = batched.parseLine(lines[i], p);
+      if (batchValid[i])
+	payments.push_back(p);
+    }
+    std::vector<std::size_t> batchMedians(payments.size());
+    batched.pushBatch(payments.data(), payments.size(), batchMedians.data());
+
+    medianDegreeEngine fast;
+    naive::engine oracle;
+    std::ostringstream expected;
+    medianWriter naiveResults(expected);
+    std::size_t batchIndex = 0;
+    boost::uint64_t pushed = 0;
+    for (std::size_t i = 0; i < lines.size(); i++) {
+      std::size_t fastMedian = 0, naiveMedian = 0, batchMedian = 0;
+      bool fastValid = fast.pushLine(lines[i], fastMedian);
+      bool naiveValid = oracle.processLine(lines[i], naiveMedian);
+      if (batchValid[i])
+	batchMedian = batchMedians[batchIndex++];
+      if (fastValid != naiveValid || (fastValid && fastMedian != naiveMedian) ||
+	  batchValid[i] != naiveValid || (batchValid[i] && batchMedian != naiveMedian)) {
+	report = (boost::format("line %1%: %2%\n  MedianDegreeEngine: %3%\n  MedianDegreeEngine, batched: %4%\n  naive: %5%\n")
+		  % (i + 1) % lines[i] % describeResult(fastValid, fastMedian) % describeResult(batchValid[i], batchMedian)
+		  % describeResult(naiveValid, naiveMedian)).str();
+	return false;
+      }
+      if (fastValid) {
+	medianSnapshot snapshot = fast.published().read();
+	if (snapshot.payments != ++pushed || snapshot.twiceMedian != fastMedian || snapshot.users != fast.graphSize() ||
+	    snapshot.edges != fast.edgeCount() || snapshot.newest != fast.newest()) {
+	  report = (boost::format("line %1%: published state is off\n") % (i + 1)).str();
+	  return false;
+	}
+      }
+      if (naiveValid)
+	naiveResults.write(naiveMedian);
+    }
+    naiveResults.flush();
+    medianSnapshot batchLast = batched.published().read(), fastLast = fast.published().read();
+    if (batchLast.payments != fastLast.payments || batchLast.users != fastLast.users ||
+	batchLast.edges != fastLast.edges || batchLast.newest != fastLast.newest) {
+      report = (boost::format("batched engine ends with %1% payments, %2% users, %3% edges, newest %4%, not %5%, %6%, %7%, %8%\n")
+		% batchLast.payments % batchLast.users % batchLast.edges % batchLast.newest
+		% fastLast.payments % fastLast.users % fastLast.edges % fastLast.newest).str();
+      return false;
+    }
+
+    const timestamp LATENESS[] = {500, 1000, 31000, 61000};
+    for (std::size_t l = 0; l < sizeof(LATENESS) / sizeof(LATENESS[0]); l++) {
+      if (!reorderedMatch(payments, LATENESS[l])) {
+	report = (boost::format("reordered with %1%ms lateness, pushInOrder and pushBatch disagree\n") % LATENESS[l]).str();
+	return false;
+      }
+    }
+
+    if (!windowedMatch(lines, 10000, 500, report) || !nestedMatch(payments, report))
+      return false;
+
+    bool polled;
+    std::string piped = pipelineOutput(lines, polled);
+    if (!polled) {
+      report = "torn or out of order snapshot published by the ingest pipeline\n";
+      return false;
+    }
+    if (piped != expected.str()) {
+      std::size_t mismatch = std::mismatch(piped.begin(), piped.begin() + std::min(piped.size(), expected.str().size()), expected.str().begin()).first - piped.begin();
+      report = (boost::format("ingest pipeline output differs from output line %1%\n")
+		% (std::count(piped.begin(), piped.begin() + mismatch, '\n') + 1)).str();
+      return false;
+    }
+    return true;
+  }
+
+}
+
+
+#if defined(MEDIAN_LIBFUZZER)
+
+extern "C" int LLVMFuzzerTestOneInput(const boost::uint8_t* data, std::size_t size)
+{
+  verbosity() = 0;
+  std::string report;
+  if (!compareEngines(decodeStream(data, size), report) || !histogramMatch(data, size, report)) {
+    std::cerr << report;
+    std::abort();
+  }
+  return 0;
+}
+
+#else
+
+int main(int argc, char* argv[]) {
+  namespace po = boost::program_options;
+
+  unsigned runs, events;
+  boost::uint64_t seed;
+  std::string dumpPath;
+  std::vector<std::string> inputs;
+
+  po::options_description options("Usage: MedianDegreeFuzz [options] [input files]\n\n"
+				  "Runs MedianDegreeEngine and the naive solution side by side on random\n"
+				  "streams, or on the given input files, and stops at the first line they\n"
+				  "disagree on.\n\n"
+				  "Options");
+  options.add_options()
+    ("help,h", "print this message")
+    ("runs,r", po::value<unsigned>(&runs)->default_value(1000), "number of random streams")
+    ("events,n", po::value<unsigned>(&events)->default_value(500), "lines per random stream")
+    ("seed,s", po::value<boost::uint64_t>(&seed)->default_value(1), "seed of the first stream; stream i uses seed + i")
+    ("dump", po::value<std::string>(&dumpPath), "write a diverging stream here, to replay as an input file")
+    ;
+  po::options_description hidden;
+  hidden.add_options()("input", po::value<std::vector<std::string> >(&inputs));
+  po::options_description all;
+  all.add(options).add(hidden);
+  po::positional_options_description positional;
+  positional.add("input", -1);
+
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).options(all).positional(positional).run(), vm);
+    po::notify(vm);
+  } catch (const po::error& e) {
+    std::cerr << e.what() << "\n\n" << options << std::endl;
+    return 1;
+  }
+  if (vm.count("help")) {
+    std::cout << options << std::endl;
+    return 0;
+  }
+
+  // the engine's debug trace would drown everything else
+  verbosity() = 0;
+  std::string report;
+
+  if (!inputs.empty()) {
+    for (std::vector<std::string>::const_iterator path = inputs.begin(); path != inputs.end(); ++path) {
+      std::ifstream input(path->c_str(), std::ifstream::binary);
+      if (!input) {
+	std::cerr << "can't read " << *path << std::endl;
+	return 1;
+      }
+      std::vector<std::string> lines;
+      std::string line;
+      while (std::getline(input, line)) {
+	lines.push_back(line);
+      }
+      if (!compareEngines(lines, report)) {
+	std::cerr << *path << ", " << report;
+	return 1;
+      }
+    }
+    std::cout << inputs.size() << " input files, no divergence" << std::endl;
+    return 0;
+  }
+
+  std::vector<boost::uint8_t> bytes(1 + 4 * events);
+  for (unsigned run = 0; run < runs; run++) {
+    std::mt19937_64 rng(seed + run);
+    for (std::size_t i = 0; i < bytes.size(); i++) {
+      bytes[i] = static_cast<boost::uint8_t>(rng());
+    }
+    std::vector<std::string> lines = decodeStream(bytes.data(), bytes.size());
+    if (!compareEngines(lines, report) || !histogramMatch(bytes.data(), bytes.size(), report)) {
+      std::cerr << "seed " << (seed + run) << ", " << report;
+      if (!dumpPath.empty()) {
+	std::ofstream dump(dumpPath.c_str(), std::ofstream::binary);
+	for (std::vector<std::string>::const_iterator line = lines.begin(); line != lines.end(); ++line) {
+	  dump << *line << '\n';
+	}
+      }
+      return 1;
+    }
+  }
+  std::cout << runs << " random streams of " << events << " lines, no divergence" << std::endl;
+  return 0;
+}
+
+#endif
@@ -11,16 +11,71 @@ cmake_minimum_required (VERSION 2.6)
 project ("Insight Coding Challenge")
 
 ## System dependencies are found with CMake's conventions
-find_package(Boost REQUIRED COMPONENTS date_time filesystem)
-include_directories(\${Boost_INCLUDE_DIRS})
+find_package(Boost REQUIRED COMPONENTS date_time filesystem program_options)
+find_package(Threads REQUIRED)
+include_directories(\${Boost_INCLUDE_DIRS} src)
 
-add_executable(MedianDegreeEngine src/median_degree_engine.cpp)
+## Our own code builds warning-clean with these; the bundled JsonCpp doesn't
+set(MEDIAN_WARNINGS -Wall -Wextra)
+
+## Median degree tracking: a degree histogram by default, or the original
+## boost ranked index with -DMEDIAN_RANKED_INDEX=ON
+option(MEDIAN_RANKED_INDEX "Track degrees in a boost ranked index instead of a histogram" OFF)
+if(MEDIAN_RANKED_INDEX)
+  add_definitions(-DMEDIAN_RANKED_INDEX)
+endif()
 
 set(JsonCpp_SOURCES "src/jsoncpp.cpp" "src/json/json.h" "src/json/json-forwards.h")
 add_library(JsonCpp \${JsonCpp_SOURCES})
 set_property(TARGET JsonCpp PROPERTY FOLDER "contrib")
 
-target_link_libraries(MedianDegreeEngine JsonCpp \${Boost_LIBRARIES})
+## The engine itself, as a static library to embed (see medianDegreeEngine in
+## src/median_degree_engine.h); MedianDegreeEngine adds the file I/O
+set(MedianDegree_SOURCES "src/median_degree_engine.cpp" "src/payment_parser.cpp" "src/timestamp.cpp" "src/median_writer.cpp" "src/nested_windows.cpp")
+add_library(MedianDegree STATIC \${MedianDegree_SOURCES})
+target_link_libraries(MedianDegree JsonCpp \${Boost_LIBRARIES})
+target_compile_options(MedianDegree PRIVATE \${MEDIAN_WARNINGS})
+
+set(MedianDegreeEngine_SOURCES "src/line_reader.cpp" "src/ingest_pipeline.cpp")
+add_executable(MedianDegreeEngine src/main.cpp \${MedianDegreeEngine_SOURCES})
+target_link_libraries(MedianDegreeEngine MedianDegree \${Boost_LIBRARIES} \${CMAKE_THREAD_LIBS_INIT})
+target_compile_options(MedianDegreeEngine PRIVATE \${MEDIAN_WARNINGS})
+
+## Synthetic payment streams, for load testing
+set(PaymentStreamGenerator_SOURCES "src/payment_stream_generator.cpp" "src/timestamp.cpp")
+add_executable(PaymentStreamGenerator src/generate_payments.cpp \${PaymentStreamGenerator_SOURCES})
+target_link_libraries(PaymentStreamGenerator \${Boost_LIBRARIES})
+target_compile_options(PaymentStreamGenerator PRIVATE \${MEDIAN_WARNINGS})
+
+## Differential fuzzing against the naive solution; ctest runs the
+## standalone driver, and -DMEDIAN_LIBFUZZER=ON (clang only) builds a
+## libFuzzer target instead. It needs fuzz/, which
+## insight_testsuite/run_tests.sh doesn't copy
+option(MEDIAN_LIBFUZZER "Build MedianDegreeFuzz as a libFuzzer target" OFF)
+enable_testing()
+if(EXISTS "\${CMAKE_SOURCE_DIR}/fuzz")
+  add_executable(MedianDegreeFuzz fuzz/differential_fuzz.cpp src/naive_engine.cpp \${MedianDegreeEngine_SOURCES})
+  target_link_libraries(MedianDegreeFuzz MedianDegree \${Boost_LIBRARIES} \${CMAKE_THREAD_LIBS_INIT})
+  target_compile_options(MedianDegreeFuzz PRIVATE \${MEDIAN_WARNINGS})
+  if(MEDIAN_LIBFUZZER)
+    target_compile_definitions(MedianDegreeFuzz PRIVATE MEDIAN_LIBFUZZER)
+    set_target_properties(MedianDegreeFuzz PROPERTIES COMPILE_FLAGS "-fsanitize=fuzzer" LINK_FLAGS "-fsanitize=fuzzer")
+  else()
+    add_test(NAME differential_fuzz COMMAND MedianDegreeFuzz --runs 300)
+    # and on every test suite input
+    file(GLOB MEDIAN_FIXTURES "\${CMAKE_SOURCE_DIR}/insight_testsuite/tests/*/venmo_input/venmo-trans.txt")
+    add_test(NAME differential_fuzz_fixtures COMMAND MedianDegreeFuzz \${MEDIAN_FIXTURES})
+  endif()
+endif()
+
+## Benchmarks are optional; they need Google Benchmark, and bench/, which
+## insight_testsuite/run_tests.sh doesn't copy
+find_package(benchmark QUIET)
+if(benchmark_FOUND AND EXISTS "\${CMAKE_SOURCE_DIR}/bench")
+  add_executable(MedianDegreeBench bench/timestamp_bench.cpp bench/parse_bench.cpp bench/engine_bench.cpp "src/payment_stream_generator.cpp")
+  target_link_libraries(MedianDegreeBench MedianDegree benchmark::benchmark benchmark::benchmark_main \${Boost_LIBRARIES})
+  target_compile_options(MedianDegreeBench PRIVATE \${MEDIAN_WARNINGS})
+endif()
 EOF
 
 if [ ! -d build ]; then
@@ -14,7 +14,7 @@ project ("Insight Coding Challenge")
 find_package(Boost REQUIRED COMPONENTS date_time filesystem)
 include_directories(\${Boost_INCLUDE_DIRS})
 
-add_executable(MedianDegreeEngine_NAIVE src/naive_solution.cpp)
+add_executable(MedianDegreeEngine_NAIVE src/naive_solution.cpp src/naive_engine.cpp)
 
 set(JsonCpp_SOURCES "src/jsoncpp.cpp" "src/json/json.h" "src/json/json-forwards.h")
 add_library(JsonCpp \${JsonCpp_SOURCES})
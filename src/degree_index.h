@@ -0,0 +1,241 @@
+#ifndef DEGREE_INDEX_H
+#define DEGREE_INDEX_H
+
+#if !defined(NDEBUG)
+#define BOOST_MULTI_INDEX_ENABLE_INVARIANT_CHECKING
+#define BOOST_MULTI_INDEX_ENABLE_SAFE_MODE
+#endif
+
+#include <boost/cstdint.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ranked_index.hpp>
+#include <boost/multi_index/identity.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+
+/*------------------------------------------------------------------------------
+  Degree indexes track the multiset of user degrees in the graph and answer
+  median queries on it. Users come and go through change(from, to), where a
+  degree of 0 means the user isn't in the graph. Medians are whole or half
+  degrees, so twiceMedian() gives them exactly as an integer.
+
+  degreeHistogram counts users per degree, and keeps cursors on the buckets
+  holding the lower and upper median. A change moves the lower one by at
+  most one non-empty bucket either way, and the upper one is at most the
+  next non-empty bucket up, so queries are O(1). Empty buckets are skipped
+  through a two-level bitset of the non-empty ones, which covers 4096
+  degrees per summary word: a change is O(1) while degrees stay under
+  that, and O(D / 4096) at worst for a maximum degree D, however sparse
+  the degrees in between.
+
+  rankedDegreeIndex is the boost ranked index the engine used originally,
+  O(log n) per update and query; build with MEDIAN_RANKED_INDEX to use it
+  instead, for comparison.
+  ------------------------------------------------------------------------------*/
+
+class degreeHistogram
+{
+public:
+  degreeHistogram() : counts(1, 0), nonEmpty(1, 0), summary(1, 0), users(0), cursor(0), upper(0), below(0) {}
+
+  void change(std::size_t from, std::size_t to)
+  {
+    if (from == to)
+      return;
+    if (from != 0) {
+      if (--counts[from] == 0)
+	clear(from);
+      users--;
+      if (from < cursor)
+	below--;
+    }
+    if (to != 0) {
+      if (to >= counts.size())
+	grow(to);
+      if (counts[to]++ == 0)
+	set(to);
+      users++;
+      if (to < cursor)
+	below++;
+    }
+    settle();
+  }
+
+  std::size_t size() const
+  {
+    return users;
+  }
+
+  std::size_t twiceMedian() const
+  {
+    return users == 0 ? 0 : cursor + upper;
+  }
+
+  double median() const
+  {
+    return twiceMedian() / 2.0;
+  }
+
+private:
+  static const std::size_t WORD = 64;
+
+  // move the cursor onto the bucket holding rank (users - 1) / 2, and the
+  // upper one onto rank users / 2
+  void settle()
+  {
+    if (users == 0) {
+      cursor = upper = below = 0;
+      return;
+    }
+    std::size_t rank = (users - 1) / 2;
+    while (rank < below) {
+      cursor = previous(cursor);
+      below -= counts[cursor];
+    }
+    while (rank >= below + counts[cursor]) {
+      below += counts[cursor];
+      cursor = next(cursor);
+    }
+    assert(counts[cursor] > 0);
+    upper = users / 2 < below + counts[cursor] ? cursor : next(cursor);
+  }
+
+  void grow(std::size_t degree)
+  {
+    counts.resize(degree + 1, 0);
+    nonEmpty.resize(degree / WORD + 1, 0);
+    summary.resize(nonEmpty.size() / WORD + 1, 0);
+  }
+
+  void set(std::size_t degree)
+  {
+    std::size_t w = degree / WORD;
+    nonEmpty[w] |= bit(degree);
+    summary[w / WORD] |= bit(w);
+  }
+
+  void clear(std::size_t degree)
+  {
+    std::size_t w = degree / WORD;
+    nonEmpty[w] &= ~bit(degree);
+    if (nonEmpty[w] == 0)
+      summary[w / WORD] &= ~bit(w);
+  }
+
+  static boost::uint64_t bit(std::size_t i)
+  {
+    return boost::uint64_t(1) << (i % WORD);
+  }
+
+  // the nearest non-empty bucket above degree; there has to be one
+  std::size_t next(std::size_t degree) const
+  {
+    std::size_t w = degree / WORD;
+    boost::uint64_t above = (degree % WORD == WORD - 1) ? 0 : nonEmpty[w] & (~boost::uint64_t(0) << (degree % WORD + 1));
+    if (above == 0) {
+      // the next non-empty word, through the summary
+      std::size_t s = w / WORD;
+      boost::uint64_t words = (w % WORD == WORD - 1) ? 0 : summary[s] & (~boost::uint64_t(0) << (w % WORD + 1));
+      while (words == 0)
+	words = summary[++s];
+      w = s * WORD + __builtin_ctzll(words);
+      above = nonEmpty[w];
+    }
+    return w * WORD + __builtin_ctzll(above);
+  }
+
+  // the nearest non-empty bucket below degree; there has to be one
+  std::size_t previous(std::size_t degree) const
+  {
+    std::size_t w = degree / WORD;
+    boost::uint64_t belowBits = nonEmpty[w] & (bit(degree) - 1);
+    if (belowBits == 0) {
+      std::size_t s = w / WORD;
+      boost::uint64_t words = summary[s] & (bit(w) - 1);
+      while (words == 0)
+	words = summary[--s];
+      w = s * WORD + (WORD - 1 - __builtin_clzll(words));
+      belowBits = nonEmpty[w];
+    }
+    return w * WORD + (WORD - 1 - __builtin_clzll(belowBits));
+  }
+
+  // counts[d] is the number of users with degree d; counts[0] stays 0
+  std::vector<std::size_t> counts;
+  // bit d of nonEmpty is set while counts[d] > 0, and bit w of summary
+  // while nonEmpty[w] is non-zero
+  std::vector<boost::uint64_t> nonEmpty;
+  std::vector<boost::uint64_t> summary;
+  std::size_t users;
+  // degrees holding the lower and upper median, and how many users sit
+  // below the lower one
+  std::size_t cursor;
+  std::size_t upper;
+  std::size_t below;
+};
+
+
+class rankedDegreeIndex
+{
+public:
+  void change(std::size_t from, std::size_t to)
+  {
+    if (from == to)
+      return;
+    if (from != 0)
+      degrees.erase(degrees.find(from));
+    if (to != 0)
+      degrees.insert(to);
+  }
+
+  std::size_t size() const
+  {
+    return degrees.size();
+  }
+
+  std::size_t twiceMedian() const
+  {
+    std::size_t size = degrees.size();
+    if (size == 0)
+      return 0;
+
+    int idx = std::ceil((size / 2.0) - 1);
+    degree_multiset::const_iterator it = degrees.nth(idx);
+
+    if (size % 2 == 0) {
+      std::size_t d1 = *it, d2 = *(++it);
+      return d1 + d2;
+    }
+    return 2 * *it;
+  }
+
+  double median() const
+  {
+    return twiceMedian() / 2.0;
+  }
+
+private:
+  typedef boost::multi_index_container<
+    std::size_t,
+    boost::multi_index::indexed_by<
+      boost::multi_index::ranked_non_unique<
+	boost::multi_index::identity<std::size_t>
+	>
+      >
+    > degree_multiset;
+
+  degree_multiset degrees;
+};
+
+
+#if defined(MEDIAN_RANKED_INDEX)
+typedef rankedDegreeIndex degree_index;
+#else
+typedef degreeHistogram degree_index;
+#endif
+
+#endif
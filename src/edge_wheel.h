@@ -0,0 +1,295 @@
+#ifndef EDGE_WHEEL_H
+#define EDGE_WHEEL_H
+
+#include <boost/cstdint.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <vector>
+
+#include "flat_hash_map.h"
+#include "timestamp.h"
+#include "user_interner.h"
+
+
+typedef boost::uint64_t edge_key;
+
+// an edge's canonical key: the lower user id, then the higher
+inline edge_key edgeKey(user_id a, user_id b)
+{
+  return a < b ? (edge_key(a) << 32) | b : (edge_key(b) << 32) | a;
+}
+
+inline user_id edgeLow(edge_key key)
+{
+  return static_cast<user_id>(key >> 32);
+}
+
+inline user_id edgeHigh(edge_key key)
+{
+  return static_cast<user_id>(key);
+}
+
+// no canonical key has a low id of 0xffffffff, so this is free to mark
+// empty slots of an edge table
+const edge_key NO_EDGE = ~edge_key(0);
+
+
+/*------------------------------------------------------------------------------
+  A window's shape: payments count while they're less than `length` behind
+  the newest one, both measured in whole ticks of `granularity`, so
+  payments within one tick are the same time as far as the window goes.
+  length has to be a whole number of ticks, and at most MAX_TICKS of them,
+  since a window's wheel has a slot per tick. The default is the
+  challenge's window, 60 seconds to the second. The constructor throws
+  std::invalid_argument for a shape that isn't a window; valid() checks
+  without throwing.
+  ------------------------------------------------------------------------------*/
+
+struct windowConfig
+{
+  // about 48 days to the second, or 70 minutes to the millisecond; 16 MiB
+  // of slots per wheel
+  static const timestamp MAX_TICKS = timestamp(1) << 22;
+
+  timestamp length;
+  timestamp granularity;
+
+  windowConfig(timestamp length_ = 60 * MILLISECONDS_PER_SECOND, timestamp granularity_ = MILLISECONDS_PER_SECOND)
+    : length(length_), granularity(granularity_)
+  {
+    if (!valid(length, granularity))
+      throw std::invalid_argument("window length must be a whole number of ticks, at most MAX_TICKS, of a positive granularity");
+  }
+
+  // whether length and granularity make a window, for checking user input
+  static bool valid(timestamp length, timestamp granularity)
+  {
+    return granularity > 0 && length >= granularity && length % granularity == 0 && length / granularity <= MAX_TICKS;
+  }
+
+  timestamp ticks() const
+  {
+    return length / granularity;
+  }
+
+  timestamp tickOf(timestamp time) const
+  {
+    return floorTicks(time, granularity);
+  }
+};
+
+
+/*------------------------------------------------------------------------------
+  A timing wheel of edges: one slot per tick of window, each slot a list of
+  the edges scheduled to expire with that tick. Times here are in ticks.
+
+  The wheel doesn't keep the edges' times; advance() asks the caller for
+  them, so wheels of different lengths can share one table of times (see
+  nested_windows.h), and edgeWheel below pairs one with a table of its own.
+  A payment refreshing an edge only updates its time in the table. The edge
+  is moved when its old slot comes up for expiry: it's rescheduled into its
+  new time's slot then, rather than expired, and every edge left in the slot
+  really is dying. So refreshes cost nothing beyond the lookup, expiry only
+  ever drops edges whose newest payment is leaving, and payments superseded
+  by a newer one on the same edge aren't kept at all.
+
+  Edges live in one node array, linked by index: the wheel's own pool, and
+  the only one the graph needs now that each edge is one fixed-size entry.
+  Nodes go back on a free list one by one as their slot expires, not in
+  bulk per tick, since every edge in the slot has to be looked at anyway to
+  see whether it was refreshed. Once the window has warmed up, nothing
+  allocates.
+  ------------------------------------------------------------------------------*/
+
+class edgeSchedule
+{
+public:
+  // length in ticks; an edge expires once its time is `length` ticks older
+  // than the head
+  explicit edgeSchedule(timestamp length_)
+    : length_(length_), slots(length_, boost::uint32_t(NIL)), freeNodes(NIL), count(0)
+  {}
+
+  timestamp length() const
+  {
+    return length_;
+  }
+
+  // edges on the wheel
+  std::size_t size() const
+  {
+    return count;
+  }
+
+  // Puts an edge that isn't on the wheel yet into time's slot.
+  void add(edge_key key, timestamp time)
+  {
+    boost::uint32_t n = allocate();
+    nodes[n].key = key;
+    schedule(n, time);
+    count++;
+  }
+
+  // Moves the head from `head` on to headTime. Each edge in a slot that
+  // comes up is looked up with timeOf(key), and either rescheduled, if it
+  // was refreshed into the window since, or dropped from the wheel after
+  // expire(key, time), oldest tick first.
+  template<typename TimeOf, typename Expire>
+  void advance(timestamp head, timestamp headTime, TimeOf timeOf, Expire expire)
+  {
+    // ticks head-length+1 .. headTime-length are expiring, but there are
+    // only `length` slots to look at
+    timestamp expiring = std::min(headTime - head, length_);
+    timestamp oldest = headTime - length_;
+    for (timestamp tick = head - length_ + 1; expiring > 0; ++tick, --expiring) {
+      boost::uint32_t n = slots[slot(tick)];
+      slots[slot(tick)] = NIL;
+      while (n != NIL) {
+	boost::uint32_t next = nodes[n].next;
+	edge_key key = nodes[n].key;
+	timestamp time = timeOf(key);
+	assert(time >= tick);
+	if (time > oldest) {
+	  // refreshed since it was scheduled, and still in the window
+	  schedule(n, time);
+	} else {
+	  expire(key, time);
+	  nodes[n].next = freeNodes;
+	  freeNodes = n;
+	  count--;
+	}
+	n = next;
+      }
+    }
+  }
+
+private:
+  static const boost::uint32_t NIL = ~boost::uint32_t(0);
+
+  struct edgeNode
+  {
+    edge_key key;
+    boost::uint32_t next;
+  };
+
+  std::size_t slot(timestamp tick) const
+  {
+    timestamp s = tick % length_;
+    return static_cast<std::size_t>(s < 0 ? s + length_ : s);
+  }
+
+  boost::uint32_t allocate()
+  {
+    if (freeNodes != NIL) {
+      boost::uint32_t n = freeNodes;
+      freeNodes = nodes[n].next;
+      return n;
+    }
+    nodes.push_back(edgeNode());
+    return static_cast<boost::uint32_t>(nodes.size() - 1);
+  }
+
+  void schedule(boost::uint32_t n, timestamp time)
+  {
+    boost::uint32_t& first = slots[slot(time)];
+    nodes[n].next = first;
+    first = n;
+  }
+
+  timestamp length_;
+  // first node of each tick's list
+  std::vector<boost::uint32_t> slots;
+  std::vector<edgeNode> nodes;
+  boost::uint32_t freeNodes;
+  std::size_t count;
+};
+
+
+/*------------------------------------------------------------------------------
+  A window's edges, each with the time of its newest payment: an
+  edgeSchedule, and a flatHashMap of the times it looks up.
+  ------------------------------------------------------------------------------*/
+
+class edgeWheel
+{
+public:
+  // length in ticks; an edge expires once its newest payment is `length`
+  // ticks older than the newest payment overall
+  explicit edgeWheel(timestamp length_)
+    : wheel(length_), times(NO_EDGE), head(0), started(false)
+  {}
+
+  bool empty() const
+  {
+    return times.empty();
+  }
+
+  // edges in the window
+  std::size_t size() const
+  {
+    return times.size();
+  }
+
+  // time of the newest payment in the window
+  timestamp newest() const
+  {
+    return head;
+  }
+
+  // Adds the edge, or refreshes it if time is newer than its current time.
+  // Returns whether the edge is new. time must not be expired already, and
+  // if it's newer than the head, advance() to it has to come first.
+  bool connect(edge_key key, timestamp time)
+  {
+    assert(!started || (time <= head && head - time < wheel.length()));
+    if (!started || time > head) {
+      head = time;
+      started = true;
+    }
+
+    timestamp* found = times.find(key);
+    if (found == 0) {
+      times.insert(key, time);
+      wheel.add(key, time);
+      return true;
+    }
+    if (*found < time) {
+      // moved when its current slot comes up
+      *found = time;
+    }
+    return false;
+  }
+
+  // Moves the head to headTime, calling expire(key, time) for every edge
+  // that falls out of the window, oldest tick first. An empty wheel just
+  // takes the new head.
+  template<typename Expire>
+  void advance(timestamp headTime, Expire expire)
+  {
+    if (started && headTime <= head)
+      return;
+    if (!empty()) {
+      wheel.advance(head, headTime, [&](edge_key key) {
+	  const timestamp* time = times.find(key);
+	  assert(time != 0);
+	  return *time;
+	}, [&](edge_key key, timestamp time) {
+	  expire(key, time);
+	  times.erase(key);
+	});
+    }
+    head = headTime;
+    started = true;
+  }
+
+private:
+  edgeSchedule wheel;
+  flatHashMap<edge_key, timestamp> times;
+  timestamp head;
+  // whether head has been set yet
+  bool started;
+};
+
+#endif
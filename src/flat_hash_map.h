@@ -0,0 +1,159 @@
+#ifndef FLAT_HASH_MAP_H
+#define FLAT_HASH_MAP_H
+
+#include <boost/cstdint.hpp>
+#include <boost/functional/hash.hpp>
+
+#include <cstddef>
+#include <vector>
+
+
+/*------------------------------------------------------------------------------
+  An open-addressing hash map over one flat array of key/value slots, for
+  small trivially copyable keys and values: lookups are a hash and a short
+  linear scan through memory that's already in cache, and there's no
+  allocation per entry.
+
+  One key value is reserved to mark empty slots, and must never be inserted.
+  Erasing shifts the rest of the probe run back instead of leaving
+  tombstones, so tables that churn don't slow down. Hashes are run through a
+  multiplicative mix before picking a slot, so identity hashes of dense ids
+  spread out fine. The table doubles at 3/4 full.
+  ------------------------------------------------------------------------------*/
+
+template <typename Key, typename Value, typename Hash = boost::hash<Key> >
+class flatHashMap
+{
+  struct slot
+  {
+    Key key;
+    Value value;
+  };
+
+  typedef std::vector<slot> slot_vector;
+
+public:
+  explicit flatHashMap(Key emptyKey_)
+    : emptyKey(emptyKey_), used(0)
+  {}
+
+  std::size_t size() const
+  {
+    return used;
+  }
+
+  bool empty() const
+  {
+    return used == 0;
+  }
+
+  Value* find(const Key& key)
+  {
+    if (slots.empty())
+      return 0;
+    for (std::size_t i = home(key); ; i = (i + 1) & mask()) {
+      if (slots[i].key == key)
+	return &slots[i].value;
+      if (slots[i].key == emptyKey)
+	return 0;
+    }
+  }
+
+  const Value* find(const Key& key) const
+  {
+    return const_cast<flatHashMap*>(this)->find(key);
+  }
+
+  // adds key with value; if key is already there, leaves it alone and
+  // returns false
+  bool insert(const Key& key, const Value& value)
+  {
+    if ((used + 1) * 4 > slots.size() * 3)
+      grow();
+    for (std::size_t i = home(key); ; i = (i + 1) & mask()) {
+      if (slots[i].key == key)
+	return false;
+      if (slots[i].key == emptyKey) {
+	slots[i].key = key;
+	slots[i].value = value;
+	used++;
+	return true;
+      }
+    }
+  }
+
+  bool erase(const Key& key)
+  {
+    if (slots.empty())
+      return false;
+    std::size_t i = home(key);
+    while (slots[i].key != key) {
+      if (slots[i].key == emptyKey)
+	return false;
+      i = (i + 1) & mask();
+    }
+
+    // pull later entries of the probe run back into the hole, unless they
+    // would end up before their home slot
+    for (std::size_t j = (i + 1) & mask(); slots[j].key != emptyKey; j = (j + 1) & mask()) {
+      std::size_t h = home(slots[j].key);
+      if (((j - h) & mask()) >= ((j - i) & mask())) {
+	slots[i] = slots[j];
+	i = j;
+      }
+    }
+    slots[i].key = emptyKey;
+    used--;
+    return true;
+  }
+
+  // f(key, value) for every entry, in no particular order
+  template <typename F>
+  void forEach(F f) const
+  {
+    for (typename slot_vector::const_iterator s = slots.begin(); s != slots.end(); ++s) {
+      if (s->key != emptyKey)
+	f(s->key, s->value);
+    }
+  }
+
+  // drops every entry, and the table's memory with them
+  void clear()
+  {
+    slot_vector().swap(slots);
+    used = 0;
+  }
+
+private:
+  std::size_t mask() const
+  {
+    return slots.size() - 1;
+  }
+
+  std::size_t home(const Key& key) const
+  {
+    boost::uint64_t h = static_cast<boost::uint64_t>(Hash()(key)) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<std::size_t>(h >> 32) & mask();
+  }
+
+  void grow()
+  {
+    slot_vector old;
+    old.swap(slots);
+    slot blank;
+    blank.key = emptyKey;
+    blank.value = Value();
+    slots.assign(old.empty() ? 8 : old.size() * 2, blank);
+    used = 0;
+    for (typename slot_vector::const_iterator s = old.begin(); s != old.end(); ++s) {
+      if (s->key != emptyKey)
+	insert(s->key, s->value);
+    }
+  }
+
+  slot_vector slots;
+  Key emptyKey;
+  std::size_t used;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include <boost/program_options.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "payment_stream_generator.h"
+
+
+int main(int argc, char* argv[]) {
+  namespace po = boost::program_options;
+
+  paymentStreamConfig config;
+  std::string outputPath, start;
+
+  po::options_description options("Usage: PaymentStreamGenerator [options]\n\n"
+				  "Writes a reproducible synthetic payment stream, one JSON object per line,\n"
+				  "for load testing MedianDegreeEngine.\n\n"
+				  "Options");
+  options.add_options()
+    ("help,h", "print this message")
+    ("output,o", po::value<std::string>(&outputPath)->default_value("-"), "where to write the stream; - writes stdout")
+    ("events,n", po::value<boost::uint64_t>(&config.events)->default_value(config.events), "number of lines")
+    ("users,u", po::value<user_id>(&config.users)->default_value(config.users), "user population")
+    ("skew", po::value<double>(&config.skew)->default_value(config.skew), "power-law exponent of how often a user pays or is paid (0: uniform)")
+    ("rate,r", po::value<double>(&config.eventsPerSecond)->default_value(config.eventsPerSecond), "payments per second of stream time")
+    ("out-of-order", po::value<double>(&config.outOfOrder)->default_value(config.outOfOrder), "fraction of payments up to 59 seconds late")
+    ("late", po::value<double>(&config.late)->default_value(config.late), "fraction of payments 60 to 120 seconds late, outside the window")
+    ("invalid", po::value<double>(&config.invalid)->default_value(config.invalid), "fraction of lines that aren't valid payments")
+    ("seed,s", po::value<boost::uint64_t>(&config.seed)->default_value(config.seed), "random seed; the same seed gives the same stream")
+    ("start", po::value<std::string>(&start)->default_value(formatTimestamp(config.start)), "timestamp of the first payment")
+    ("subsecond", "stamp payments to the millisecond, rather than the second")
+    ;
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, options), vm);
+    po::notify(vm);
+  } catch (const po::error& e) {
+    std::cerr << e.what() << "\n\n" << options << std::endl;
+    return 1;
+  }
+  if (vm.count("help")) {
+    std::cout << options << std::endl;
+    return 0;
+  }
+  config.subsecond = vm.count("subsecond") > 0;
+  if (!parseTimestamp(start, config.start)) {
+    std::cerr << "bad start time " << start << "; expected YYYY-MM-DDTHH:MM:SSZ" << std::endl;
+    return 1;
+  }
+
+  std::ofstream outputFile;
+  if (outputPath != "-") {
+    outputFile.open(outputPath.c_str(), std::ofstream::binary);
+    if (!outputFile) {
+      std::cerr << "can't write " << outputPath << std::endl;
+      return 1;
+    }
+  }
+  std::ostream& output = outputPath == "-" ? std::cout : outputFile;
+  std::ios_base::sync_with_stdio(false);
+
+  paymentStreamGenerator generator(config);
+  std::string line;
+  for (boost::uint64_t i = 0; i < config.events; i++) {
+    generator.nextLine(line);
+    line += '\n';
+    output.write(line.data(), line.size());
+  }
+  output.flush();
+  if (!output) {
+    std::cerr << "error writing " << outputPath << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,197 @@
+#include "ingest_pipeline.h"
+
+#include <boost/utility/string_view.hpp>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "payment_parser.h"
+#include "spsc_ring.h"
+
+
+namespace {
+
+  // chunks in flight per ring; enough to ride out uneven lines
+  const std::size_t RING_CHUNKS = 4;
+
+  struct parsedPayment
+  {
+    boost::string_view actor;
+    boost::string_view target;
+    timestamp time;
+  };
+
+  struct ingestChunk
+  {
+    std::vector<boost::string_view> lines;
+    // the lines' text, when the reader's views don't last
+    std::string text;
+    std::vector<std::size_t> ends;
+
+    std::vector<parsedPayment> parsed;
+    // names the parser had to decode (escapes), so they aren't in the line
+    std::deque<std::string> decodedNames;
+
+    std::vector<payment> payments;
+    std::vector<std::size_t> twiceMedians;
+
+    void clear()
+    {
+      lines.clear();
+      text.clear();
+      ends.clear();
+      parsed.clear();
+      decodedNames.clear();
+      payments.clear();
+    }
+  };
+
+  typedef spscRing<ingestChunk*> chunk_ring;
+
+  // a null chunk is the end of the input
+  bool readChunk(lineReader& input, ingestChunk& chunk, std::size_t chunkLines)
+  {
+    boost::string_view line;
+    if (input.stableViews()) {
+      while (chunk.lines.size() < chunkLines && input.next(line)) {
+	chunk.lines.push_back(line);
+      }
+    } else {
+      while (chunk.ends.size() < chunkLines && input.next(line)) {
+	chunk.text.append(line.data(), line.size());
+	chunk.ends.push_back(chunk.text.size());
+      }
+      std::size_t begin = 0;
+      for (std::vector<std::size_t>::const_iterator end = chunk.ends.begin(); end != chunk.ends.end(); ++end) {
+	chunk.lines.push_back(boost::string_view(chunk.text.data() + begin, *end - begin));
+	begin = *end;
+      }
+    }
+    return !chunk.lines.empty();
+  }
+
+  // field, or a copy of it if it isn't in the line and so won't outlive
+  // the parser's next parse()
+  boost::string_view keep(boost::string_view field, boost::string_view line, std::deque<std::string>& storage)
+  {
+    if (field.data() >= line.data() && field.data() + field.size() <= line.data() + line.size())
+      return field;
+    storage.push_back(field.to_string());
+    return storage.back();
+  }
+
+  void parseChunks(chunk_ring& in, chunk_ring& out)
+  {
+    paymentParser parser;
+    paymentFields fields;
+    for (;;) {
+      ingestChunk* chunk = in.pop();
+      if (chunk) {
+	for (std::vector<boost::string_view>::const_iterator line = chunk->lines.begin(); line != chunk->lines.end(); ++line) {
+	  parsedPayment p;
+	  if (parsePaymentLine(parser, *line, fields, p.time)) {
+	    p.actor = keep(fields.actor, *line, chunk->decodedNames);
+	    p.target = keep(fields.target, *line, chunk->decodedNames);
+	    chunk->parsed.push_back(p);
+	  }
+	}
+      }
+      out.push(chunk);
+      if (!chunk)
+	return;
+    }
+  }
+
+  void applyChunks(std::vector<std::unique_ptr<chunk_ring> >& in, medianDegreeEngine& engine, chunk_ring& out)
+  {
+    userInterner& users = engine.users();
+    for (std::size_t n = 0; ; n++) {
+      ingestChunk* chunk = in[n % in.size()]->pop();
+      if (!chunk) {
+	out.push(0);
+	return;
+      }
+      for (std::vector<parsedPayment>::const_iterator p = chunk->parsed.begin(); p != chunk->parsed.end(); ++p) {
+	chunk->payments.push_back(payment(users.intern(p->actor), users.intern(p->target), p->time));
+      }
+      chunk->twiceMedians.resize(chunk->payments.size() * engine.windowCount());
+      engine.pushBatch(chunk->payments.data(), chunk->payments.size(), chunk->twiceMedians.data());
+      out.push(chunk);
+    }
+  }
+
+  void writeChunks(chunk_ring& in, medianWriter& results, std::size_t windows, chunk_ring& recycled)
+  {
+    for (;;) {
+      ingestChunk* chunk = in.pop();
+      if (!chunk)
+	return;
+      if (windows == 1) {
+	for (std::size_t i = 0; i < chunk->payments.size(); i++) {
+	  results.write(chunk->twiceMedians[i]);
+	}
+      } else {
+	for (std::size_t i = 0; i < chunk->payments.size(); i++) {
+	  results.writeRow(&chunk->twiceMedians[i * windows], windows);
+	}
+      }
+      chunk->clear();
+      if (!recycled.tryPush(chunk))
+	delete chunk;
+    }
+  }
+
+}
+
+
+void runIngestPipeline(lineReader& input, medianDegreeEngine& engine, medianWriter& results,
+		       unsigned parserThreads, std::size_t chunkLines)
+{
+  if (parserThreads == 0)
+    parserThreads = 1;
+
+  std::vector<std::unique_ptr<chunk_ring> > toParsers, fromParsers;
+  for (unsigned k = 0; k < parserThreads; k++) {
+    toParsers.push_back(std::unique_ptr<chunk_ring>(new chunk_ring(RING_CHUNKS)));
+    fromParsers.push_back(std::unique_ptr<chunk_ring>(new chunk_ring(RING_CHUNKS)));
+  }
+  chunk_ring toWriter(RING_CHUNKS);
+  // room for every chunk that can be in flight at once
+  chunk_ring recycled(RING_CHUNKS * (2 * parserThreads + 1) + parserThreads + 2);
+
+  std::vector<std::thread> threads;
+  for (unsigned k = 0; k < parserThreads; k++) {
+    threads.push_back(std::thread(parseChunks, std::ref(*toParsers[k]), std::ref(*fromParsers[k])));
+  }
+  threads.push_back(std::thread(applyChunks, std::ref(fromParsers), std::ref(engine), std::ref(toWriter)));
+  threads.push_back(std::thread(writeChunks, std::ref(toWriter), std::ref(results), engine.windowCount(), std::ref(recycled)));
+
+  std::size_t n = 0;
+  for (;;) {
+    ingestChunk* chunk;
+    if (!recycled.tryPop(chunk))
+      chunk = new ingestChunk;
+    if (!readChunk(input, *chunk, chunkLines)) {
+      delete chunk;
+      break;
+    }
+    toParsers[n++ % parserThreads]->push(chunk);
+  }
+  // every parser gets an end marker, starting where the applier will look
+  // for the next chunk
+  for (unsigned k = 0; k < parserThreads; k++) {
+    toParsers[(n + k) % parserThreads]->push(0);
+  }
+
+  for (std::vector<std::thread>::iterator t = threads.begin(); t != threads.end(); ++t) {
+    t->join();
+  }
+  ingestChunk* chunk;
+  while (recycled.tryPop(chunk)) {
+    delete chunk;
+  }
+}
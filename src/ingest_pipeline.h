@@ -0,0 +1,31 @@
+#ifndef INGEST_PIPELINE_H
+#define INGEST_PIPELINE_H
+
+#include <cstddef>
+
+#include "line_reader.h"
+#include "median_degree_engine.h"
+#include "median_writer.h"
+
+
+/*------------------------------------------------------------------------------
+  Multi-threaded ingest, for when decoding lines is the bottleneck:
+
+    reader (the calling thread) -> parser threads -> applier -> writer
+
+  The reader cuts the input into chunks of lines and deals them out
+  round-robin to the parsers, over one SPSC ring each. Parsers decode and
+  validate payments, keeping names as views into the chunk. The applier
+  collects chunks back from the parsers in the same round-robin order, so
+  input order is kept without any sequencing. It interns the names (it's
+  the only thread touching the engine) and pushes each chunk through
+  pushBatch. The writer formats the medians, and returns the chunk to the
+  reader for reuse.
+
+  Output is exactly what pushing the lines through pushLine in order gives.
+  ------------------------------------------------------------------------------*/
+
+void runIngestPipeline(lineReader& input, medianDegreeEngine& engine, medianWriter& results,
+		       unsigned parserThreads, std::size_t chunkLines = 1024);
+
+#endif
@@ -232,7 +232,9 @@ static inline void fixNumericLocale(char* begin, char* end) {
 #endif
 
 static int const stackLimit_g = 1000;
-static int       stackDepth_g = 0;  // see readValue()
+// thread_local, so Readers on different threads (the ingest pipeline's
+// parsers) don't share one depth count
+static thread_local int stackDepth_g = 0;  // see readValue()
 
 namespace Json {
 
@@ -0,0 +1,132 @@
+#include "line_reader.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+mappedLineReader::mappedLineReader(const std::string& path)
+  : data(0), size(0), cursor(0)
+{
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+
+  struct stat st;
+  if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void* region = ::mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (region != MAP_FAILED) {
+      // lines are read front to back exactly once
+      ::madvise(region, st.st_size, MADV_SEQUENTIAL);
+      data = cursor = static_cast<const char*>(region);
+      size = st.st_size;
+    }
+  }
+  // the mapping outlives the descriptor
+  ::close(fd);
+}
+
+mappedLineReader::~mappedLineReader()
+{
+  if (data)
+    ::munmap(const_cast<char*>(data), size);
+}
+
+bool mappedLineReader::next(boost::string_view& line)
+{
+  const char* end = data + size;
+  if (cursor == 0 || cursor == end)
+    return false;
+
+  // same splitting as std::getline: the newline is dropped, and a final
+  // line without one still counts
+  const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+  const char* lineEnd = newline ? newline : end;
+  line = boost::string_view(cursor, lineEnd - cursor);
+  cursor = newline ? newline + 1 : end;
+  return true;
+}
+
+
+streamLineReader::streamLineReader(const std::string& path)
+  : file(path.c_str(), std::ifstream::binary), stream(file)
+{}
+
+streamLineReader::streamLineReader(std::istream& in)
+  : stream(in)
+{}
+
+bool streamLineReader::next(boost::string_view& line)
+{
+  if (!std::getline(stream, buffer))
+    return false;
+  line = buffer;
+  return true;
+}
+
+
+descriptorLineReader::descriptorLineReader(int fd_)
+  : fd(fd_), buffer(1 << 16), start(0), end(0), eof(false)
+{}
+
+bool descriptorLineReader::next(boost::string_view& line)
+{
+  for (;;) {
+    const char* first = &buffer[0] + start;
+    const char* newline = static_cast<const char*>(std::memchr(first, '\n', end - start));
+    if (newline) {
+      line = boost::string_view(first, newline - first);
+      start = newline + 1 - &buffer[0];
+      return true;
+    }
+    if (eof) {
+      // as std::getline: a final line without a newline still counts
+      if (start == end)
+	return false;
+      line = boost::string_view(first, end - start);
+      start = end;
+      return true;
+    }
+
+    // make room for the rest of the line, then wait for it
+    if (start > 0) {
+      std::memmove(&buffer[0], first, end - start);
+      end -= start;
+      start = 0;
+    }
+    if (end == buffer.size())
+      buffer.resize(2 * buffer.size());
+    ssize_t n = ::read(fd, &buffer[end], buffer.size() - end);
+    if (n > 0)
+      end += n;
+    else if (n == 0 || errno != EINTR)
+      eof = true;
+  }
+}
+
+bool descriptorLineReader::ready() const
+{
+  return eof || std::memchr(&buffer[0] + start, '\n', end - start) != 0;
+}
+
+
+std::unique_ptr<lineReader> openLineReader(const std::string& path, bool allowMapping)
+{
+  if (path == "-")
+    return std::unique_ptr<lineReader>(new descriptorLineReader(STDIN_FILENO));
+
+  if (allowMapping) {
+    std::unique_ptr<mappedLineReader> mapped(new mappedLineReader(path));
+    if (mapped->mapped())
+      return std::unique_ptr<lineReader>(mapped.release());
+  }
+
+  std::unique_ptr<streamLineReader> streamed(new streamLineReader(path));
+  if (!streamed->good())
+    return std::unique_ptr<lineReader>();
+  return std::unique_ptr<lineReader>(streamed.release());
+}
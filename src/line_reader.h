@@ -0,0 +1,111 @@
+#ifndef LINE_READER_H
+#define LINE_READER_H
+
+#include <boost/utility/string_view.hpp>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/*------------------------------------------------------------------------------
+  Input lines, handed out as views. A view stays valid until the next call
+  to next(), and for a mappedLineReader until the reader is destroyed.
+  ------------------------------------------------------------------------------*/
+
+class lineReader
+{
+public:
+  virtual ~lineReader() {}
+
+  // false once the input is exhausted
+  virtual bool next(boost::string_view& line) = 0;
+
+  // whether next() can return without waiting for more input; only a pipe
+  // or terminal ever has to
+  virtual bool ready() const
+  {
+    return true;
+  }
+
+  // whether views stay valid for the reader's lifetime, past the next call
+  virtual bool stableViews() const
+  {
+    return false;
+  }
+};
+
+// Maps the whole file and splits lines in place; nothing is copied.
+class mappedLineReader : public lineReader
+{
+public:
+  // check mapped() afterwards; the file may be missing, empty or unmappable
+  explicit mappedLineReader(const std::string& path);
+  ~mappedLineReader();
+
+  bool mapped() const
+  {
+    return data != 0;
+  }
+
+  bool next(boost::string_view& line);
+
+  bool stableViews() const
+  {
+    return true;
+  }
+
+private:
+  mappedLineReader(const mappedLineReader&);
+  mappedLineReader& operator = (const mappedLineReader&);
+
+  const char* data;
+  std::size_t size;
+  const char* cursor;
+};
+
+// std::getline into a reused buffer, from a file or an existing stream
+class streamLineReader : public lineReader
+{
+public:
+  explicit streamLineReader(const std::string& path);
+  explicit streamLineReader(std::istream& in);
+
+  bool good() const
+  {
+    return !stream.fail();
+  }
+
+  bool next(boost::string_view& line);
+
+private:
+  std::ifstream file;
+  std::istream& stream;
+  std::string buffer;
+};
+
+// Reads a descriptor (stdin) directly, into a buffer that grows to fit the
+// longest line, so that ready() can tell whether a whole line is buffered.
+class descriptorLineReader : public lineReader
+{
+public:
+  explicit descriptorLineReader(int fd_);
+
+  bool next(boost::string_view& line);
+
+  bool ready() const;
+
+private:
+  int fd;
+  std::vector<char> buffer;
+  // unread bytes are buffer[start, end)
+  std::size_t start, end;
+  bool eof;
+};
+
+// "-" reads stdin. Otherwise path is memory-mapped when allowed and
+// possible, and streamed if not. Returns null if path can't be read.
+std::unique_ptr<lineReader> openLineReader(const std::string& path, bool allowMapping = true);
+
+#endif
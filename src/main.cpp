@@ -0,0 +1,178 @@
+#include <boost/program_options.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ingest_pipeline.h"
+#include "line_reader.h"
+#include "median_degree_engine.h"
+#include "reorder_buffer.h"
+#include "verbose_output.h"
+
+// defaults, relative to build/
+const std::string INPUT_FILE = "../venmo_input/venmo-trans.txt";
+const std::string OUTPUT_FILE = "../venmo_output/output.txt";
+
+
+int main(int argc, char* argv[]) {
+  namespace po = boost::program_options;
+
+  std::string inputPath, outputPath, windowLength, windowGranularity, maxLatenessText;
+  unsigned flushInterval, batchSize, parseThreads;
+
+  po::options_description options("Usage: MedianDegreeEngine [options]\n\n"
+				  "Writes the median degree of the payment graph over a sliding window (60\n"
+				  "seconds by default) after every valid payment, one per line. Given\n"
+				  "several windows, each line has a median for every window, in order.\n\n"
+				  "Options");
+  options.add_options()
+    ("help,h", "print this message")
+    ("input,i", po::value<std::string>(&inputPath)->default_value(INPUT_FILE), "payments, one JSON object per line; - reads stdin")
+    ("output,o", po::value<std::string>(&outputPath)->default_value(OUTPUT_FILE), "where to write medians; - writes stdout")
+    ("flush-interval", po::value<unsigned>(&flushInterval)->default_value(0), "also flush output at most this many milliseconds apart (0: only when the buffer fills, when stdin has no complete line waiting, and at exit)")
+    ("no-mmap", "read the input with getline instead of memory-mapping it")
+    ("parse-threads", po::value<unsigned>(&parseThreads)->default_value(0), "decode lines on this many threads, with graph updates and output on two more (0: everything on one thread; stdin always is)")
+    ("window", po::value<std::string>(&windowLength)->default_value("60s"), "window length: a whole number of ms, s, m or h; several, comma-separated (10s,60s,300s), are kept in one pass, with one median each")
+    ("granularity", po::value<std::string>(&windowGranularity)->default_value("1s"), "the window's resolution; payments in the same tick count as the same time, and the window has to be a whole number of ticks, at most 4194304 (48 days at 1s)")
+    ("max-lateness", po::value<std::string>(&maxLatenessText)->default_value("0"), "put payments back in time order first, holding each until the stream is this far past it: a duration like 250ms or 2s; medians then follow that order, and payments later still go in as they come (0, or any zero duration: off; not with --parse-threads)")
+    ("batch-size", po::value<unsigned>(&batchSize)->default_value(4096), "payments pushed to the engine at once; stdin always goes one at a time, so medians aren't held back waiting for a full batch")
+#if !defined(NDEBUG)
+    ("verbosity,v", po::value<int>(&verbosity()), "debug trace level, 0 to 2 (default: $MEDIAN_DEGREE_VERBOSITY, or 2)")
+#endif
+    ;
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, options), vm);
+    po::notify(vm);
+  } catch (const po::error& e) {
+    std::cerr << e.what() << "\n\n" << options << std::endl;
+    return 1;
+  }
+  if (vm.count("help")) {
+    std::cout << options << std::endl;
+    return 0;
+  }
+
+  std::vector<windowConfig> windows;
+  timestamp granularity;
+  bool windowsValid = parseDuration(windowGranularity, granularity);
+  for (std::size_t start = 0; windowsValid && start <= windowLength.size(); ) {
+    std::size_t end = std::min(windowLength.find(',', start), windowLength.size());
+    timestamp length;
+    windowsValid = parseDuration(boost::string_view(windowLength).substr(start, end - start), length) &&
+      windowConfig::valid(length, granularity);
+    if (windowsValid)
+      windows.push_back(windowConfig(length, granularity));
+    start = end + 1;
+  }
+  if (!windowsValid) {
+    std::cerr << "bad window " << windowLength << " at granularity " << windowGranularity
+	      << "; expected durations like 500ms, 10s, 15m or 1h, each window a multiple of the granularity and at most "
+	      << timestamp(windowConfig::MAX_TICKS) << " ticks of it" << std::endl;
+    return 1;
+  }
+  timestamp maxLateness = 0;
+  if (!parseDuration(maxLatenessText, maxLateness)) {
+    std::cerr << "bad --max-lateness " << maxLatenessText << "; expected a duration like 250ms, 2s or 1m" << std::endl;
+    return 1;
+  }
+  if (maxLateness > 0 && parseThreads > 0) {
+    std::cerr << "--max-lateness can't be combined with --parse-threads" << std::endl;
+    return 1;
+  }
+
+  std::unique_ptr<medianDegreeEngine> engine(windows.size() > 1 ? new medianDegreeEngine(windows)
+					      : new medianDegreeEngine(windows[0]));
+  std::size_t windowCount = engine->windowCount();
+
+  std::unique_ptr<lineReader> input = openLineReader(inputPath, !vm.count("no-mmap"));
+  if (!input) {
+    std::cerr << "can't read " << inputPath << std::endl;
+    return 1;
+  }
+
+  std::ofstream resultsFile;
+  if (outputPath != "-") {
+    resultsFile.open(outputPath.c_str(), std::ofstream::binary);
+    if (!resultsFile) {
+      std::cerr << "can't write " << outputPath << std::endl;
+      return 1;
+    }
+  }
+  medianWriter results(outputPath == "-" ? std::cout : resultsFile, 1 << 16, std::chrono::milliseconds(flushInterval));
+
+  if (parseThreads > 0 && inputPath != "-") {
+    runIngestPipeline(*input, *engine, results, parseThreads);
+  } else {
+    if (inputPath == "-" || batchSize == 0)
+      batchSize = 1;
+    std::vector<payment> batch;
+    batch.reserve(batchSize);
+    std::vector<std::size_t> twiceMedians(batchSize * windowCount);
+
+    // with --max-lateness, batches come out of the reorder buffer in time
+    // order, and take the engine's in-order path
+    std::unique_ptr<reorderBuffer> reorder;
+    if (maxLateness > 0)
+      reorder.reset(new reorderBuffer(maxLateness));
+
+    auto pushAndWrite = [&](const payment* payments, std::size_t count, bool inOrder) {
+      if (twiceMedians.size() < count * windowCount)
+	twiceMedians.resize(count * windowCount);
+      if (inOrder)
+	engine->pushInOrder(payments, count, twiceMedians.data());
+      else
+	engine->pushBatch(payments, count, twiceMedians.data());
+      if (windowCount == 1) {
+	for (std::size_t i = 0; i < count; i++) {
+	  results.write(twiceMedians[i]);
+	}
+      } else {
+	for (std::size_t i = 0; i < count; i++) {
+	  results.writeRow(&twiceMedians[i * windowCount], windowCount);
+	}
+      }
+    };
+
+    boost::string_view currline;
+    payment p;
+    bool more = true;
+
+    while (more) {
+      // everything written so far goes out before waiting on the input,
+      // however long the collector stays quiet
+      if (!input->ready())
+	results.flush();
+      more = input->next(currline);
+      if (more && engine->parseLine(currline, p)) {
+	if (!reorder) {
+	  batch.push_back(p);
+	} else if (!reorder->push(p, batch)) {
+	  // too late to put back in order; it goes after what's been released
+	  pushAndWrite(batch.data(), batch.size(), true);
+	  batch.clear();
+	  pushAndWrite(&p, 1, false);
+	}
+      }
+      if (!more && reorder)
+	reorder->flush(batch);
+      if (batch.size() >= batchSize || (!more && !batch.empty())) {
+	pushAndWrite(batch.data(), batch.size(), reorder != nullptr);
+	batch.clear();
+      }
+    }
+  }
+
+  input.reset();
+  results.flush();
+  resultsFile.close();
+
+  return 0;
+}
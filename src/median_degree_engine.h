@@ -0,0 +1,189 @@
+#ifndef MEDIAN_DEGREE_ENGINE_H
+#define MEDIAN_DEGREE_ENGINE_H
+
+#include <boost/cstdint.hpp>
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "degree_index.h"
+#include "edge_wheel.h"
+#include "median_writer.h"
+#include "payment.h"
+#include "payment_parser.h"
+#include "published_median.h"
+#include "timestamp.h"
+#include "user_interner.h"
+
+
+/*------------------------------------------------------------------------------
+  Payments are streamed in, parsed into timestamped connections. User names
+  are interned into dense ids on the way in; everything past the parser works
+  on ids, and only debug output resolves them back to names.
+
+  Each connection is stored once, under its canonical key (the lower id of
+  the two users, then the higher), with the time of the newest payment
+  between them, on a timing wheel that expires it when that payment leaves
+  the window. Users' degrees are kept alongside, as counts.
+
+  The new connection is added if not already present, otherwise the timestamp is
+  updated.
+
+  The functions below work in the window's ticks (see windowConfig): payment
+  times passed to them are window.tickOf() the payment's timestamp.
+  ------------------------------------------------------------------------------*/
+
+struct connection_set
+{
+  windowConfig window;
+  edgeWheel edges;
+  // by user id; users without connections are still in here, at degree 0,
+  // but they aren't part of the graph as far as the degree index goes
+  std::vector<boost::uint32_t> userDegrees;
+
+  explicit connection_set(const windowConfig& window_ = windowConfig())
+    : window(window_), edges(window_.ticks())
+  {}
+};
+
+// Considers p for the window: payments a window's length or more behind
+// the newest one are dropped, newer ones purge whatever they push out of
+// the window, and p's connection is added or refreshed on both sides.
+void addOrUpdateConnections(const payment& p, connection_set& cs, degree_index& degrees, const userInterner& users);
+
+// The two halves of addOrUpdateConnections. admitPayments decides for every
+// payment at `time` at once: false if they're too far behind to be kept,
+// otherwise true, after purging anything they push out of the window.
+// connectPayment then adds an admitted payment.
+bool admitPayments(timestamp time, connection_set& cs, degree_index& degrees, const userInterner& users);
+void connectPayment(const payment& p, connection_set& cs, degree_index& degrees);
+
+// moves the window's head to headTime, dropping connections whose newest
+// payment expires with it
+void purgePaymentWindow(timestamp headTime, connection_set& cs, degree_index& degrees, const userInterner& users);
+
+// Parses and validates a JSON input line, tracing why it's rejected if it
+// is. The fields are only valid until the parser's next parse().
+bool parsePaymentLine(paymentParser& parser, boost::string_view line, paymentFields& fields, timestamp& time);
+
+// debug trace of the graph and its median, at verbosity 2 and 1
+void traceRank(const connection_set& cs, const degree_index& degrees, const userInterner& users);
+
+void printRank(const connection_set& cs, const degree_index& degrees, medianWriter& results, const userInterner& users);
+
+
+/*------------------------------------------------------------------------------
+  The engine as a library: one instance owns a window, the graph built from
+  it, and the users seen so far, and nothing else is shared between
+  instances. Payments are pushed in stream order, each push returning the
+  median degree right after it.
+
+  An engine can also keep several windows over the same payments, each with
+  a median of its own (see nested_windows.h); then the batch calls give one
+  median per window for every payment, and the rest of the interface
+  describes the first window.
+
+  Medians are returned doubled, since the median of whole degrees is always a
+  whole or half number: 3 is 1.5, and medianWriter takes it as is.
+  ------------------------------------------------------------------------------*/
+
+class nestedWindows;
+
+class medianDegreeEngine
+{
+public:
+  explicit medianDegreeEngine(const windowConfig& window = windowConfig());
+
+  // One median per window, in this order, for each payment. The windows
+  // have to share one granularity.
+  explicit medianDegreeEngine(const std::vector<windowConfig>& windows);
+  ~medianDegreeEngine();
+
+  // p's parties must be ids from users()
+  std::size_t push(const payment& p);
+
+  std::size_t push(boost::string_view actor, boost::string_view target, timestamp time);
+
+  // Parses and validates a JSON input line, and pushes it if it's a valid
+  // payment. Returns false, leaving twiceMedian_ alone, if it isn't.
+  bool pushLine(boost::string_view line, std::size_t& twiceMedian_);
+
+  // pushLine without the push: false if the line isn't a valid payment,
+  // otherwise the payment, its parties interned, goes in p
+  bool parseLine(boost::string_view line, payment& p);
+
+  // Pushes count payments, writing the medians after each to twiceMedians,
+  // windowCount() per payment; the medians are the same as count push()
+  // calls would give. Runs of payments in the same tick (bursts are common)
+  // are admitted and purge the window once per run rather than once per
+  // payment.
+  void pushBatch(const payment* payments, std::size_t count, std::size_t* twiceMedians);
+
+  // pushBatch for payments already in time order, none older than newest()
+  // (see reorder_buffer.h): nothing can be too late, and only a new tick
+  // can move the window, so each payment is a purge check and an add.
+  void pushInOrder(const payment* payments, std::size_t count, std::size_t* twiceMedians);
+
+  std::size_t twiceMedian() const
+  {
+    return twiceMedian(0);
+  }
+
+  // of the w'th window
+  std::size_t twiceMedian(std::size_t w) const;
+
+  double median() const
+  {
+    return twiceMedian() / 2.0;
+  }
+
+  std::size_t windowCount() const;
+
+  userInterner& users()
+  {
+    return users_;
+  }
+
+  const userInterner& users() const
+  {
+    return users_;
+  }
+
+  // users with at least one connection in the window
+  std::size_t graphSize() const;
+
+  std::size_t edgeCount() const;
+
+  // time of the newest payment in the window, to the tick
+  timestamp newest() const;
+
+  const windowConfig& window() const
+  {
+    return cs.window;
+  }
+
+  // The state after the latest payment, republished after every one. Unlike
+  // the rest of the engine, it can be read from any thread, while pushes go
+  // on, without slowing them down; see published_median.h.
+  const publishedMedian& published() const
+  {
+    return published_;
+  }
+
+private:
+  connection_set cs;
+  degree_index degrees;
+  // null unless there's more than one window; then it holds the graph, and
+  // cs goes unused
+  std::unique_ptr<nestedWindows> nested;
+  // push()'s row of medians, one per window, when nested
+  std::vector<std::size_t> pushMedians;
+  publishedMedian published_;
+  userInterner users_;
+  paymentParser parser;
+  paymentFields fields;
+};
+
+#endif
@@ -0,0 +1,25 @@
+#include "median_writer.h"
+
+#include <algorithm>
+
+
+medianWriter::medianWriter(std::ostream& out_, std::size_t bufferSize, std::chrono::milliseconds flushInterval_)
+  : out(out_), buffer(std::max<std::size_t>(bufferSize, 64)), used(0), flushInterval(flushInterval_),
+    nextFlush(std::chrono::steady_clock::now() + flushInterval_)
+{}
+
+medianWriter::~medianWriter()
+{
+  flush();
+}
+
+void medianWriter::flush()
+{
+  if (used > 0) {
+    out.write(&buffer[0], used);
+    used = 0;
+  }
+  out.flush();
+  if (flushInterval.count() > 0)
+    nextFlush = std::chrono::steady_clock::now() + flushInterval;
+}
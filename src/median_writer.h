@@ -0,0 +1,85 @@
+#ifndef MEDIAN_WRITER_H
+#define MEDIAN_WRITER_H
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+
+/*------------------------------------------------------------------------------
+  Writes one median per line (or a row of them, space-separated, for
+  several windows), formatted with two decimals, into a user-space
+  buffer that only goes out to the stream when it fills up, when
+  flushInterval has passed since the last flush (if one is set), or on
+  flush()/destruction.
+
+  A median degree is always k/2 for some integer k, so lines are formatted
+  from k directly: k/2, then ".00" or ".50". No floating point, no locale.
+  ------------------------------------------------------------------------------*/
+
+class medianWriter
+{
+public:
+  explicit medianWriter(std::ostream& out_,
+			std::size_t bufferSize = 1 << 16,
+			std::chrono::milliseconds flushInterval_ = std::chrono::milliseconds(0));
+  ~medianWriter();
+
+  // writes twiceMedian / 2, e.g. 3 -> "1.50"
+  void write(std::size_t twiceMedian)
+  {
+    put(twiceMedian, '\n');
+    flushIfDue();
+  }
+
+  // writes count medians on one line, e.g. {3, 4} -> "1.50 2.00"
+  void writeRow(const std::size_t* twiceMedians, std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; i++) {
+      put(twiceMedians[i], i + 1 < count ? ' ' : '\n');
+    }
+    flushIfDue();
+  }
+
+  void flush();
+
+private:
+  void put(std::size_t twiceMedian, char end)
+  {
+    // 20 digits for a 64 bit size_t, plus ".50\n"
+    if (used + 24 > buffer.size())
+      flush();
+
+    char digits[20];
+    char* d = digits + sizeof(digits);
+    std::size_t whole = twiceMedian / 2;
+    do {
+      *--d = static_cast<char>('0' + whole % 10);
+      whole /= 10;
+    } while (whole != 0);
+
+    char* next = &buffer[used];
+    for (; d != digits + sizeof(digits); ++d)
+      *next++ = *d;
+    *next++ = '.';
+    *next++ = (twiceMedian & 1) ? '5' : '0';
+    *next++ = '0';
+    *next++ = end;
+    used = next - &buffer[0];
+  }
+
+  void flushIfDue()
+  {
+    if (flushInterval.count() > 0 && std::chrono::steady_clock::now() >= nextFlush)
+      flush();
+  }
+
+  std::ostream& out;
+  std::vector<char> buffer;
+  std::size_t used;
+  std::chrono::milliseconds flushInterval;
+  std::chrono::steady_clock::time_point nextFlush;
+};
+
+#endif
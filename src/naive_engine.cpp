@@ -0,0 +1,156 @@
+#include "naive_engine.h"
+
+#include <boost/algorithm/string.hpp>
+
+#include <algorithm>
+#include <regex>
+#include <stdexcept>
+
+
+namespace naive {
+
+payment::payment(const std::string& actor_, const std::string& target_, const std::string& time_)
+  : actor(actor_), target(target_)
+{
+  // YYYY-MM-DDTHH:MM:SS[.fffffffff]Z, to the millisecond; anything else,
+  // and any field out of range, leaves time not-a-date-time
+  static const std::regex format("(\\d{4})-(\\d{2})-(\\d{2})T(\\d{2}):(\\d{2}):(\\d{2})(?:\\.(\\d{1,9}))?Z");
+  std::smatch fields;
+  if (!std::regex_match(time_, fields, format))
+    return;
+  int hour = std::stoi(fields[4]), minute = std::stoi(fields[5]), second = std::stoi(fields[6]);
+  if (hour > 23 || minute > 59 || second > 59)
+    return;
+  std::string fraction = fields[7].str() + "000";
+  try {
+    boost::gregorian::date day(std::stoi(fields[1]), std::stoi(fields[2]), std::stoi(fields[3]));
+    time = boost::posix_time::ptime(day, boost::posix_time::time_duration(hour, minute, second) +
+				    boost::posix_time::milliseconds(std::stoi(fraction.substr(0, 3))));
+  } catch (const std::out_of_range&) {
+    // no such day, or year out of boost's range
+  }
+}
+
+boost::posix_time::time_duration timeDuration0(0,0,0,0);
+
+void purgePaymentSet(payment_set& ps, boost::posix_time::ptime headTime, boost::posix_time::time_duration length) {
+  payment_set::iterator it = ps.begin();
+  while(headTime - it->time >= length) {
+    it = ps.erase(it);
+  }
+}
+
+void processPayment(const payment& p, payment_set& ps, boost::posix_time::time_duration length)
+{
+  // check if new time is a window or more behind
+  payment_set::reverse_iterator rit = ps.rbegin();
+  
+  if (rit != ps.rend()) {
+    payment newestPayment = *rit;
+
+    if (newestPayment.time - p.time >= length) {
+      // out of the window; do nothing
+    } else {
+      ps.insert(p);
+    }
+
+    if ((p.time - newestPayment.time) > timeDuration0) {
+      purgePaymentSet(ps, p.time, length);
+    } else {
+      // payment out of order, no purge needed
+    }
+
+  } else {
+    // initializing payment recieved
+    ps.insert(p);
+  }
+}
+
+void _bcv(const payment& p, user_connection_set& uc) {
+  user_connection_set::iterator uiter = uc.find(p.actor);
+  if (uiter == uc.end()) {
+    std::shared_ptr<userConnections> tmpUc(new userConnections(p));
+    uc[p.actor] = tmpUc;
+  } else {
+    connection_set::const_iterator citer = uiter->second->connections.find(p.target);
+    if (citer == uiter->second->connections.end()) {
+      uiter->second->connections.insert(p.target);
+    } else {
+      // connection exists, do nothing
+    }
+  }
+}
+
+void buildConnectionsVector(const payment_set& ps, user_connection_set& uc) {
+  for(payment_set::const_iterator piter = ps.begin(); piter != ps.end(); piter++) {
+    _bcv(*piter, uc);
+    _bcv(piter->reverse(), uc);
+  }
+}
+
+std::vector<size_t> findDegrees(const user_connection_set& uc) {
+  std::vector<size_t> degrees;
+  for(user_connection_set::const_iterator uciter = uc.begin(); uciter != uc.end(); uciter++) {
+    degrees.push_back(uciter->second->degree());
+  }
+  std::sort(degrees.begin(), degrees.end());
+  return degrees;
+}
+
+std::size_t twiceMedian(const std::vector<size_t>& degrees) {
+  std::size_t size = degrees.size();
+  if (size == 0)
+    return 0;
+  if (size % 2 == 0) {
+    return degrees[size/2-1] + degrees[size/2];
+  }
+  return 2 * degrees[size/2];
+}
+
+
+bool engine::processLine(const std::string& line, std::size_t& twiceMedian_)
+{
+  if (!jsonReader.parse(line, root, false)) {
+    // invalid json
+    return false;
+  }
+
+  if (!root.isMember("actor") || boost::trim_copy(root["actor"].asString()) == "") {
+    // invalid actor field; passing on this payment entry
+    return false;
+  }
+  if (!root.isMember("target") || boost::trim_copy(root["target"].asString()) == "") {
+    // invalid target field; passing on this payment entry
+    return false;
+  }
+  if (boost::trim_copy(root["target"].asString()) == boost::trim_copy(root["actor"].asString())) {
+    // reflexive payment; passing on this payment entry
+    return false;
+  }
+  if (!root.isMember("created_time")) {
+    // missing created_time field; passing on this payment
+    // validation will happen in payment constructor
+    return false;
+  }
+
+  payment p(root["actor"].asString(), root["target"].asString(), root["created_time"].asString());
+    
+  if (p.time.is_not_a_date_time()) {
+    // invalid date time; passing on this payment
+    return false;
+  }
+
+  // down to the start of its tick
+  boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+  boost::int64_t ms = (p.time - epoch).total_milliseconds(), tick = granularity.total_milliseconds();
+  ms = (ms >= 0 ? ms / tick : (ms - tick + 1) / tick) * tick;
+  p.time = epoch + boost::posix_time::milliseconds(ms);
+
+  processPayment(p, ps, length);
+  user_connection_set uc;
+  buildConnectionsVector(ps, uc);
+  twiceMedian_ = twiceMedian(findDegrees(uc));
+  return true;
+}
+
+}
@@ -0,0 +1,119 @@
+#ifndef NAIVE_ENGINE_H
+#define NAIVE_ENGINE_H
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "json/json.h"
+
+
+/*------------------------------------------------------------------------------
+Payments are streamed in, parsed into timestamped connections. 
+
+The set of connections by user (userConnections) is located for each user.
+
+The new connection is added if not already present, otherwise the timestamp is 
+updated.
+
+This is the naive solution: it keeps only the window of payments,
+and rebuilds the whole graph from it for every event. It shares no code with
+MedianDegreeEngine past jsoncpp, so it serves as the oracle the fast engine is
+checked against (see fuzz/differential_fuzz.cpp). Everything lives in the
+`naive` namespace so both can be linked into one binary.
+------------------------------------------------------------------------------*/
+
+namespace naive {
+
+struct payment
+{
+  std::string actor;
+  std::string target;
+  boost::posix_time::ptime time;
+
+  payment(const std::string& actor_, const std::string& target_, const std::string& time_);
+
+  payment(const std::string& actor_, const std::string& target_, const boost::posix_time::ptime time_)
+    : actor(actor_), target(target_), time(time_)
+  {}
+
+  const payment reverse() const
+  {
+    return payment(target, actor, time);
+  }  
+  
+  struct Compare {
+    size_t operator () (const payment& p1, const payment& p2) const {
+      if (p1.time != p2.time)
+	return p1.time < p2.time;
+      if (p1.actor != p2.actor)
+	return p1.actor < p2.actor;
+      if (p1.target != p2.target)
+	return p1.target < p2.target;
+      return false;
+    }
+  };
+
+};
+
+typedef std::unordered_set<std::string> connection_set;
+struct userConnections
+{
+  std::string actor;
+  connection_set connections;
+
+  userConnections(const payment& p)
+    : actor(p.actor)
+  {
+    connections.insert(p.target);
+  }
+
+  std::size_t degree() const
+  {
+    return connections.size();
+  }
+  
+};
+
+typedef std::set<payment, payment::Compare> payment_set;
+typedef std::map<std::string, std::shared_ptr<userConnections>> user_connection_set;
+
+void purgePaymentSet(payment_set& ps, boost::posix_time::ptime headTime, boost::posix_time::time_duration length);
+void processPayment(const payment& p, payment_set& ps, boost::posix_time::time_duration length);
+void buildConnectionsVector(const payment_set& ps, user_connection_set& uc);
+std::vector<size_t> findDegrees(const user_connection_set& uc);
+
+// median of sorted degrees, doubled so it's always a whole number
+std::size_t twiceMedian(const std::vector<size_t>& degrees);
+
+
+// One input line at a time, as the original main loop handled them, over a
+// window of `length`, with times cut down to whole multiples of granularity.
+class engine
+{
+public:
+  explicit engine(boost::posix_time::time_duration length_ = boost::posix_time::seconds(60),
+		  boost::posix_time::time_duration granularity_ = boost::posix_time::seconds(1))
+    : length(length_), granularity(granularity_)
+  {}
+
+  // false if the line isn't a valid payment; otherwise the payment is
+  // processed, and the new median (doubled) goes in twiceMedian_
+  bool processLine(const std::string& line, std::size_t& twiceMedian_);
+
+private:
+  boost::posix_time::time_duration length;
+  boost::posix_time::time_duration granularity;
+  payment_set ps;
+  Json::Value root;
+  Json::Reader jsonReader;
+};
+
+}
+
+#endif
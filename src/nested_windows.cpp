@@ -0,0 +1,117 @@
+#include "nested_windows.h"
+
+#include <algorithm>
+#include <cassert>
+
+
+nestedWindows::nestedWindows(const std::vector<windowConfig>& windows_)
+  : granularity(windows_.at(0).granularity), longest(0), times(NO_EDGE), started(false), head(0)
+{
+  for (std::size_t w = 0; w < windows_.size(); w++) {
+    assert(windows_[w].granularity == granularity);
+    windows.push_back(window(windows_[w].ticks()));
+    if (windows[w].wheel.length() > windows[longest].wheel.length())
+      longest = w;
+  }
+}
+
+void nestedWindows::changeDegree(window& win, user_id u, int delta)
+{
+  if (u >= win.userDegrees.size())
+    win.userDegrees.resize(u + 1, 0);
+  std::size_t degree = win.userDegrees[u];
+  win.userDegrees[u] = static_cast<boost::uint32_t>(degree + delta);
+  win.degrees.change(degree, degree + delta);
+}
+
+void nestedWindows::expire(window& win, timestamp headTime, bool longest_)
+{
+  win.wheel.advance(head, headTime, [&](edge_key key) {
+      const timestamp* time = times.find(key);
+      assert(time != 0);
+      return *time;
+    }, [&](edge_key key, timestamp) {
+      changeDegree(win, edgeLow(key), -1);
+      changeDegree(win, edgeHigh(key), -1);
+      if (longest_)
+	times.erase(key);
+    });
+}
+
+void nestedWindows::advance(timestamp headTime)
+{
+  // the longest window last: it drops edges from the shared table, which
+  // the others still look their times up in
+  for (std::size_t w = 0; w < windows.size(); w++) {
+    if (w != longest)
+      expire(windows[w], headTime, false);
+  }
+  expire(windows[longest], headTime, true);
+  head = headTime;
+}
+
+bool nestedWindows::admit(timestamp tick)
+{
+  if (!times.empty()) {
+    if (head - tick >= windows[longest].wheel.length())
+      return false;
+    if (tick > head)
+      advance(tick);
+  }
+  return true;
+}
+
+void nestedWindows::connect(const payment& p, timestamp tick)
+{
+  if (!started || tick > head) {
+    head = tick;
+    started = true;
+  }
+
+  edge_key key = edgeKey(p.actor, p.target);
+  timestamp* found = times.find(key);
+  bool known = found != 0;
+  timestamp before = 0;
+  if (known) {
+    if (*found >= tick)
+      return;
+    before = *found;
+    *found = tick;
+  } else {
+    times.insert(key, tick);
+  }
+
+  // windows it's new to: those it had left, or had never made it into
+  for (std::vector<window>::iterator win = windows.begin(); win != windows.end(); ++win) {
+    if ((!known || head - before >= win->wheel.length()) && head - tick < win->wheel.length()) {
+      win->wheel.add(key, tick);
+      changeDegree(*win, p.actor, 1);
+      changeDegree(*win, p.target, 1);
+    }
+  }
+}
+
+void nestedWindows::pushBatch(const payment* payments, std::size_t count, std::size_t* twiceMedians,
+			      publishedMedian& published)
+{
+  std::size_t i = 0;
+  while (i < count) {
+    // a run of payments in the same tick, as in medianDegreeEngine::pushBatch
+    timestamp tick = floorTicks(payments[i].time, granularity);
+    std::size_t end = i + 1;
+    while (end < count && floorTicks(payments[end].time, granularity) == tick) {
+      end++;
+    }
+
+    bool admitted = admit(tick);
+    for (; i < end; i++) {
+      if (admitted)
+	connect(payments[i], tick);
+      std::size_t* row = twiceMedians + i * windows.size();
+      for (std::size_t w = 0; w < windows.size(); w++) {
+	row[w] = windows[w].degrees.twiceMedian();
+      }
+      published.publish(row[0], windows[0].degrees.size(), windows[0].wheel.size(), newest());
+    }
+  }
+}
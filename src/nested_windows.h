@@ -0,0 +1,106 @@
+#ifndef NESTED_WINDOWS_H
+#define NESTED_WINDOWS_H
+
+#include <boost/cstdint.hpp>
+
+#include <vector>
+
+#include "degree_index.h"
+#include "edge_wheel.h"
+#include "flat_hash_map.h"
+#include "payment.h"
+#include "published_median.h"
+
+
+/*------------------------------------------------------------------------------
+  Several windows of different lengths over the one stream, at the same
+  granularity, kept in a single pass. A window only ever holds the edges of
+  a longer one, so they can share almost everything:
+
+  - one table of edges, keyed as in edge_wheel.h, each with the time of its
+    newest payment, kept for as long as the longest window holds the edge;
+  - per window, only a timing wheel of its own length, the degrees of its
+    own graph and their histogram.
+
+  Admission and the head go by the longest window. A payment too old for a
+  shorter window could only be behind the head, so it moves nothing there;
+  and since the head is the same for all windows, an edge is in a window
+  exactly when its newest time is less than the window's length behind it,
+  which is what a separate engine per window would keep.
+
+  Each window's wheel is an edgeSchedule, as under edgeWheel, looking its
+  edges' times up in the shared table. A refresh that brings an edge back
+  into a shorter window it had left puts it on that window's wheel again,
+  so every window has each edge on its wheel at most once.
+  ------------------------------------------------------------------------------*/
+
+class nestedWindows
+{
+public:
+  // Windows in any order; results come in the same order. They all have to
+  // share one granularity.
+  explicit nestedWindows(const std::vector<windowConfig>& windows_);
+
+  std::size_t windowCount() const
+  {
+    return windows.size();
+  }
+
+  // medianDegreeEngine::pushBatch, writing windowCount() medians per
+  // payment, one after the other, and publishing the first window's state
+  // after each
+  void pushBatch(const payment* payments, std::size_t count, std::size_t* twiceMedians, publishedMedian& published);
+
+  std::size_t twiceMedian(std::size_t w) const
+  {
+    return windows[w].degrees.twiceMedian();
+  }
+
+  // users with at least one connection in window w
+  std::size_t graphSize(std::size_t w) const
+  {
+    return windows[w].degrees.size();
+  }
+
+  std::size_t edgeCount(std::size_t w) const
+  {
+    return windows[w].wheel.size();
+  }
+
+  // time of the newest payment, to the tick
+  timestamp newest() const
+  {
+    return head * granularity;
+  }
+
+private:
+  struct window
+  {
+    edgeSchedule wheel;
+    std::vector<boost::uint32_t> userDegrees;
+    degree_index degrees;
+
+    // length in ticks
+    explicit window(timestamp length)
+      : wheel(length)
+    {}
+  };
+
+  bool admit(timestamp tick);
+  void advance(timestamp headTime);
+  void expire(window& win, timestamp headTime, bool longest);
+  void connect(const payment& p, timestamp tick);
+  void changeDegree(window& win, user_id u, int delta);
+
+  timestamp granularity;
+  std::vector<window> windows;
+  // index of the longest window, which admission goes by
+  std::size_t longest;
+  // the newest payment's tick of every edge in the longest window
+  flatHashMap<edge_key, timestamp> times;
+  bool started;
+  // in ticks
+  timestamp head;
+};
+
+#endif
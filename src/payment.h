@@ -0,0 +1,23 @@
+#ifndef PAYMENT_H
+#define PAYMENT_H
+
+#include "timestamp.h"
+#include "user_interner.h"
+
+
+// A validated payment, as a flat record: both parties are interned ids.
+struct payment
+{
+  user_id actor;
+  user_id target;
+  timestamp time;
+
+  payment() : actor(0), target(0), time(0) {}
+
+  payment(const user_id actor_, const user_id target_, const timestamp time_)
+    : actor(actor_), target(target_), time(time_)
+  {}
+
+};
+
+#endif
@@ -0,0 +1,180 @@
+#include "payment_parser.h"
+
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+  inline bool isJsonSpace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  }
+
+  inline const char* skipSpaces(const char* p, const char* end)
+  {
+    while (p != end && isJsonSpace(*p))
+      ++p;
+    return p;
+  }
+
+  // p points just past an opening quote. Returns the end of the string's
+  // contents, or null if it is unterminated or needs unescaping.
+  inline const char* scanString(const char* p, const char* end)
+  {
+    for (; p != end; ++p) {
+      if (*p == '"')
+	return p;
+      if (*p == '\\')
+	return 0;
+    }
+    return 0;
+  }
+
+  // same whitespace set boost::trim_copy used on these fields
+  boost::string_view trim(boost::string_view s)
+  {
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front())))
+      s.remove_prefix(1);
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back())))
+      s.remove_suffix(1);
+    return s;
+  }
+
+}
+
+
+paymentParser::status paymentParser::parse(boost::string_view line, paymentFields& fields)
+{
+  bool hasActor = false, hasTarget = false, hasTime = false;
+  fields = paymentFields();
+
+  if (!scan(line, fields, hasActor, hasTarget, hasTime)) {
+    // not the plain flat object we expect; let jsoncpp decide
+    fields = paymentFields();
+    hasActor = hasTarget = hasTime = false;
+    if (!fallback(line, fields, hasActor, hasTarget, hasTime))
+      return INVALID_JSON;
+  }
+
+  boost::string_view actor = trim(fields.actor), target = trim(fields.target);
+  if (!hasActor || actor.empty())
+    return INVALID_ACTOR;
+  if (!hasTarget || target.empty())
+    return INVALID_TARGET;
+  if (actor == target)
+    return REFLEXIVE;
+  if (!hasTime)
+    // validation of the value itself happens when the time is parsed
+    return MISSING_CREATED_TIME;
+  return VALID;
+}
+
+// Accepts only `{ "key": "value", ... }` with unescaped strings throughout;
+// returns false for anything else so it can go through jsoncpp instead.
+bool paymentParser::scan(boost::string_view line, paymentFields& fields, bool& hasActor, bool& hasTarget, bool& hasTime) const
+{
+  const char* p = line.data();
+  const char* end = p + line.size();
+
+  p = skipSpaces(p, end);
+  if (p == end || *p != '{')
+    return false;
+  p = skipSpaces(p + 1, end);
+
+  if (p != end && *p == '}') {
+    p++;
+  } else {
+    while (true) {
+      if (p == end || *p != '"')
+	return false;
+      const char* keyEnd = scanString(++p, end);
+      if (!keyEnd)
+	return false;
+      boost::string_view key(p, keyEnd - p);
+
+      p = skipSpaces(keyEnd + 1, end);
+      if (p == end || *p != ':')
+	return false;
+      p = skipSpaces(p + 1, end);
+      if (p == end || *p != '"')
+	return false;
+      const char* valueEnd = scanString(++p, end);
+      if (!valueEnd)
+	return false;
+      boost::string_view value(p, valueEnd - p);
+
+      // duplicate keys: the last one wins, same as jsoncpp
+      if (key == "actor") {
+	fields.actor = value;
+	hasActor = true;
+      } else if (key == "target") {
+	fields.target = value;
+	hasTarget = true;
+      } else if (key == "created_time") {
+	fields.createdTime = value;
+	hasTime = true;
+      }
+
+      p = skipSpaces(valueEnd + 1, end);
+      if (p == end)
+	return false;
+      if (*p == '}') {
+	p++;
+	break;
+      }
+      if (*p != ',')
+	return false;
+      p = skipSpaces(p + 1, end);
+    }
+  }
+
+  return skipSpaces(p, end) == end;
+}
+
+bool paymentParser::fallback(boost::string_view line, paymentFields& fields, bool& hasActor, bool& hasTarget, bool& hasTime)
+{
+  if (!jsonReader.parse(line.data(), line.data() + line.size(), root, false))
+    return false;
+  if (!root.isObject())
+    // null, scalars and arrays have no members to speak of
+    return true;
+
+  hasActor = fallbackField("actor", actorStorage, fields.actor);
+  hasTarget = fallbackField("target", targetStorage, fields.target);
+  hasTime = fallbackField("created_time", timeStorage, fields.createdTime);
+  return true;
+}
+
+bool paymentParser::fallbackField(const char* key, std::string& storage, boost::string_view& field)
+{
+  const Json::Value* value = root.find(key, key + std::strlen(key));
+  if (value == 0 || !value->isConvertibleTo(Json::stringValue))
+    return false;
+  storage = value->asString();
+  field = storage;
+  return true;
+}
+
+std::string paymentParser::errorMessages() const
+{
+  return jsonReader.getFormattedErrorMessages();
+}
+
+const char* paymentParser::describe(status s)
+{
+  switch (s) {
+  case VALID:
+    return "valid payment";
+  case INVALID_JSON:
+    return "discarding payment input; invalid json";
+  case INVALID_ACTOR:
+    return "invalid actor field; passing on this payment entry";
+  case INVALID_TARGET:
+    return "invalid target field; passing on this payment entry";
+  case REFLEXIVE:
+    return "reflexive payment; passing on this payment entry";
+  case MISSING_CREATED_TIME:
+    return "missing created_time field; passing on this payment entry";
+  }
+  return "unknown parse status";
+}
@@ -0,0 +1,61 @@
+#ifndef PAYMENT_PARSER_H
+#define PAYMENT_PARSER_H
+
+#include <boost/utility/string_view.hpp>
+
+#include <string>
+
+#include "json/json.h"
+
+
+/*------------------------------------------------------------------------------
+  Payment lines only ever carry three flat string fields (created_time, actor,
+  target), so the parser scans those straight out of the line buffer as views,
+  without building a Json::Value tree or copying any strings.
+
+  Anything the scanner doesn't handle itself (escape sequences, comments,
+  non-string values, malformed lines) is handed to Json::Reader, so what gets
+  accepted or rejected is exactly what the full jsoncpp path would decide.
+  ------------------------------------------------------------------------------*/
+
+struct paymentFields
+{
+  boost::string_view actor;
+  boost::string_view target;
+  boost::string_view createdTime;
+};
+
+class paymentParser
+{
+public:
+  enum status {
+    VALID,
+    INVALID_JSON,
+    INVALID_ACTOR,
+    INVALID_TARGET,
+    REFLEXIVE,
+    MISSING_CREATED_TIME
+  };
+
+  // Fields are views into `line`, or into this parser when the line needed
+  // the jsoncpp fallback; either way they are valid until the next parse().
+  status parse(boost::string_view line, paymentFields& fields);
+
+  // jsoncpp's error report for the last INVALID_JSON line
+  std::string errorMessages() const;
+
+  static const char* describe(status s);
+
+private:
+  bool scan(boost::string_view line, paymentFields& fields, bool& hasActor, bool& hasTarget, bool& hasTime) const;
+  bool fallback(boost::string_view line, paymentFields& fields, bool& hasActor, bool& hasTarget, bool& hasTime);
+  bool fallbackField(const char* key, std::string& storage, boost::string_view& field);
+
+  Json::Reader jsonReader;
+  Json::Value root;
+  std::string actorStorage;
+  std::string targetStorage;
+  std::string timeStorage;
+};
+
+#endif
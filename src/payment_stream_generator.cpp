@@ -0,0 +1,134 @@
+#include "payment_stream_generator.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+paymentStreamGenerator::paymentStreamGenerator(const paymentStreamConfig& config_)
+  : config(config_), rng(config_.seed), emitted(0)
+{
+  if (config.users < 2)
+    config.users = 2;
+  if (config.eventsPerSecond <= 0)
+    config.eventsPerSecond = 1;
+
+  cumulative.resize(config.users);
+  double total = 0;
+  for (user_id u = 0; u < config.users; u++) {
+    total += 1.0 / std::pow(u + 1.0, config.skew);
+    cumulative[u] = total;
+  }
+}
+
+// [0, 1) from the top 53 bits
+double paymentStreamGenerator::uniform()
+{
+  return (rng() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+user_id paymentStreamGenerator::party()
+{
+  double x = uniform() * cumulative.back();
+  std::vector<double>::const_iterator it = std::upper_bound(cumulative.begin(), cumulative.end(), x);
+  return static_cast<user_id>(std::min<std::size_t>(it - cumulative.begin(), config.users - 1));
+}
+
+payment paymentStreamGenerator::next()
+{
+  const timestamp SECOND = MILLISECONDS_PER_SECOND;
+  timestamp t = config.start;
+  if (config.subsecond)
+    t += static_cast<timestamp>(emitted * SECOND / config.eventsPerSecond);
+  else
+    t += static_cast<timestamp>(emitted / config.eventsPerSecond) * SECOND;
+  emitted++;
+
+  double lateness = uniform();
+  if (lateness < config.outOfOrder) {
+    t -= config.subsecond ? 1 + static_cast<timestamp>(uniform() * (60 * SECOND - 1))
+      : (1 + static_cast<timestamp>(uniform() * 59)) * SECOND;
+  } else if (lateness < config.outOfOrder + config.late) {
+    t -= config.subsecond ? 60 * SECOND + static_cast<timestamp>(uniform() * 61 * SECOND)
+      : (60 + static_cast<timestamp>(uniform() * 61)) * SECOND;
+  }
+
+  user_id actor = party(), target = party();
+  if (actor == target)
+    target = (target + 1) % config.users;
+  return payment(actor, target, t);
+}
+
+void paymentStreamGenerator::nextLine(std::string& line)
+{
+  line.clear();
+  if (config.invalid > 0 && uniform() < config.invalid) {
+    appendInvalid(line);
+  } else {
+    appendPayment(next(), line);
+  }
+}
+
+void paymentStreamGenerator::appendPayment(const payment& p, std::string& line)
+{
+  line += "{\"created_time\": \"";
+  line += formatTimestamp(p.time);
+  line += "\", \"target\": \"user-";
+  line += std::to_string(p.target);
+  line += "\", \"actor\": \"user-";
+  line += std::to_string(p.actor);
+  line += "\"}";
+}
+
+void paymentStreamGenerator::appendInvalid(std::string& line)
+{
+  // built around a real payment, so invalid lines track the stream's clock
+  payment p = next();
+  std::string time = formatTimestamp(p.time);
+  std::string actor = "user-" + std::to_string(p.actor), target = "user-" + std::to_string(p.target);
+
+  switch (rng() % 6) {
+  case 0:
+    appendPayment(p, line);
+    line.resize(line.size() / 2);
+    break;
+  case 1:
+    line = "{\"created_time\": \"" + time + "\", \"target\": \"" + target + "\"}";
+    break;
+  case 2:
+    line = "{\"created_time\": \"" + time + "\", \"target\": \"\", \"actor\": \"" + actor + "\"}";
+    break;
+  case 3:
+    line = "{\"created_time\": \"" + time + "\", \"target\": \"" + actor + "\", \"actor\": \"" + actor + "\"}";
+    break;
+  case 4:
+    time[5] = '1';
+    time[6] = '3';
+    line = "{\"created_time\": \"" + time + "\", \"target\": \"" + target + "\", \"actor\": \"" + actor + "\"}";
+    break;
+  default:
+    line = "// not a payment";
+    break;
+  }
+}
+
+
+std::vector<payment> generatePayments(const paymentStreamConfig& config)
+{
+  paymentStreamGenerator generator(config);
+  std::vector<payment> payments;
+  payments.reserve(config.events);
+  for (boost::uint64_t i = 0; i < config.events; i++) {
+    payments.push_back(generator.next());
+  }
+  return payments;
+}
+
+std::vector<std::string> generateLines(const paymentStreamConfig& config)
+{
+  paymentStreamGenerator generator(config);
+  std::vector<std::string> lines(config.events);
+  for (boost::uint64_t i = 0; i < config.events; i++) {
+    generator.nextLine(lines[i]);
+  }
+  return lines;
+}
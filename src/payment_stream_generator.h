@@ -0,0 +1,84 @@
+#ifndef PAYMENT_STREAM_GENERATOR_H
+#define PAYMENT_STREAM_GENERATOR_H
+
+#include <boost/cstdint.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "payment.h"
+#include "timestamp.h"
+
+
+/*------------------------------------------------------------------------------
+  Reproducible synthetic payment streams, for load tests and benchmarks.
+
+  Both parties of a payment are drawn from `users` ids with probability
+  proportional to 1 / (id + 1)^skew: skew 0 is uniform, and around 1 gives
+  the power-law degree distribution of real payment graphs. The clock starts
+  at `start` and moves at eventsPerSecond, in whole seconds, or with
+  subsecond set, to the millisecond. A payment is stamped up to 59 seconds
+  in the past with probability outOfOrder (late, but still in the default
+  window), or 60 to 120 seconds in the past with probability late (too late
+  for it).
+
+  As text, a fraction `invalid` of the lines are broken in one of the ways
+  the engine has to reject: truncated JSON, missing or empty fields,
+  reflexive payments, bad timestamps, comments.
+
+  All sampling is done here on top of mt19937_64, rather than with the
+  <random> distributions, whose output differs between standard libraries,
+  so a seed produces the same stream everywhere.
+  ------------------------------------------------------------------------------*/
+
+struct paymentStreamConfig
+{
+  boost::uint64_t events;
+  user_id users;
+  double skew;
+  double eventsPerSecond;
+  double outOfOrder;
+  double late;
+  double invalid;
+  boost::uint64_t seed;
+  timestamp start;
+  bool subsecond;
+
+  // 2016-04-07T03:33:19Z, the first timestamp in the challenge example
+  paymentStreamConfig()
+    : events(100000), users(10000), skew(1.0), eventsPerSecond(1000),
+      outOfOrder(0.05), late(0.01), invalid(0.01), seed(42), start(1459999999 * MILLISECONDS_PER_SECOND),
+      subsecond(false)
+  {}
+};
+
+class paymentStreamGenerator
+{
+public:
+  explicit paymentStreamGenerator(const paymentStreamConfig& config_);
+
+  // the next valid payment
+  payment next();
+
+  // the next line of the stream: a payment as JSON, or an invalid line
+  void nextLine(std::string& line);
+
+private:
+  double uniform();
+  user_id party();
+  void appendPayment(const payment& p, std::string& line);
+  void appendInvalid(std::string& line);
+
+  paymentStreamConfig config;
+  std::mt19937_64 rng;
+  // cumulative, unnormalized party weights
+  std::vector<double> cumulative;
+  boost::uint64_t emitted;
+};
+
+// convenience for benchmarks: the first config.events payments, or lines
+std::vector<payment> generatePayments(const paymentStreamConfig& config);
+std::vector<std::string> generateLines(const paymentStreamConfig& config);
+
+#endif
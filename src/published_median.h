@@ -0,0 +1,103 @@
+#ifndef PUBLISHED_MEDIAN_H
+#define PUBLISHED_MEDIAN_H
+
+#include <boost/cstdint.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+#include "timestamp.h"
+
+
+// the engine's state right after one payment
+struct medianSnapshot
+{
+  // valid payments pushed so far, this one included
+  boost::uint64_t payments;
+  std::size_t twiceMedian;
+  // users with at least one connection, and connections, in the window
+  std::size_t users;
+  std::size_t edges;
+  // time of the newest payment in the window
+  timestamp newest;
+
+  double median() const
+  {
+    return twiceMedian / 2.0;
+  }
+};
+
+
+/*------------------------------------------------------------------------------
+  The latest medianSnapshot, for any number of reader threads, behind a
+  seqlock: the one writer bumps the sequence to odd, stores the fields,
+  and bumps it to even again. Readers copy the fields between two loads of
+  the sequence, and try again if it was odd or moved in between.
+
+  The writer never waits on readers, and only pays a handful of plain
+  stores per snapshot, so the engine publishes after every payment. Readers
+  don't block each other, and only retry while a publish is actually in
+  progress. Fields are relaxed atomics, so the copy is never a data race,
+  only possibly torn, and then discarded.
+  ------------------------------------------------------------------------------*/
+
+class publishedMedian
+{
+public:
+  publishedMedian()
+    : sequence(0), payments(0), twiceMedian(0), users(0), edges(0), newest(0), published(0)
+  {}
+
+  // writer thread only
+  void publish(std::size_t twiceMedian_, std::size_t users_, std::size_t edges_, timestamp newest_)
+  {
+    boost::uint64_t s = sequence.load(std::memory_order_relaxed);
+    sequence.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    payments.store(++published, std::memory_order_relaxed);
+    twiceMedian.store(twiceMedian_, std::memory_order_relaxed);
+    users.store(users_, std::memory_order_relaxed);
+    edges.store(edges_, std::memory_order_relaxed);
+    newest.store(newest_, std::memory_order_relaxed);
+    sequence.store(s + 2, std::memory_order_release);
+  }
+
+  // from any thread; all zeros until the first payment
+  medianSnapshot read() const
+  {
+    medianSnapshot snapshot;
+    while (!tryRead(snapshot)) {
+      std::this_thread::yield();
+    }
+    return snapshot;
+  }
+
+  // false, leaving snapshot undefined, if a publish got in the way
+  bool tryRead(medianSnapshot& snapshot) const
+  {
+    boost::uint64_t before = sequence.load(std::memory_order_acquire);
+    if (before & 1)
+      return false;
+    snapshot.payments = payments.load(std::memory_order_relaxed);
+    snapshot.twiceMedian = twiceMedian.load(std::memory_order_relaxed);
+    snapshot.users = users.load(std::memory_order_relaxed);
+    snapshot.edges = edges.load(std::memory_order_relaxed);
+    snapshot.newest = newest.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return sequence.load(std::memory_order_relaxed) == before;
+  }
+
+private:
+  // readers only ever share this line with the writer, not `published`
+  alignas(64) std::atomic<boost::uint64_t> sequence;
+  std::atomic<boost::uint64_t> payments;
+  std::atomic<std::size_t> twiceMedian;
+  std::atomic<std::size_t> users;
+  std::atomic<std::size_t> edges;
+  std::atomic<timestamp> newest;
+  // the writer's own count
+  alignas(64) boost::uint64_t published;
+};
+
+#endif
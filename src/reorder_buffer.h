@@ -0,0 +1,121 @@
+#ifndef REORDER_BUFFER_H
+#define REORDER_BUFFER_H
+
+#include <boost/cstdint.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <vector>
+
+#include "payment.h"
+
+
+/*------------------------------------------------------------------------------
+  Puts a stream of payments back in time order, as long as none is more
+  than `lateness` milliseconds behind the newest one seen. Payments wait in
+  (time, arrival) order, and are released once the stream has moved
+  `lateness` past them, oldest first; payments at the same time keep their
+  arrival order.
+
+  Most payments arrive in order, and those are simply appended to a sorted
+  run; only the ones arriving out of order go into a min-heap. Releasing
+  takes the older of the run's front and the heap's top.
+
+  A payment arriving after a newer one has already been released can't be
+  put back in order; push() turns it away, and it's up to the caller to
+  take it some other way.
+  ------------------------------------------------------------------------------*/
+
+class reorderBuffer
+{
+public:
+  explicit reorderBuffer(timestamp lateness_)
+    : lateness(lateness_), newestSeen(std::numeric_limits<timestamp>::min()),
+      released(std::numeric_limits<timestamp>::min()), arrivals(0)
+  {}
+
+  // Takes p, appending whatever it lets out to `out`, in time order. False,
+  // leaving p to the caller, if p is already too late.
+  bool push(const payment& p, std::vector<payment>& out)
+  {
+    if (p.time < released)
+      return false;
+    newestSeen = std::max(newestSeen, p.time);
+
+    entry e(p, arrivals++);
+    if (run.empty() || !later(run.back(), e)) {
+      run.push_back(e);
+    } else {
+      heap.push_back(e);
+      std::push_heap(heap.begin(), heap.end(), later);
+    }
+    while (size() > 0 && newestSeen - oldest().p.time >= lateness) {
+      release(out);
+    }
+    return true;
+  }
+
+  // releases everything still held, at the end of the stream
+  void flush(std::vector<payment>& out)
+  {
+    while (size() > 0) {
+      release(out);
+    }
+  }
+
+  std::size_t size() const
+  {
+    return run.size() + heap.size();
+  }
+
+private:
+  struct entry
+  {
+    payment p;
+    boost::uint64_t arrival;
+
+    entry(const payment& p_, boost::uint64_t arrival_) : p(p_), arrival(arrival_) {}
+  };
+
+  // heap order: the oldest payment, then the first to arrive, on top
+  static bool later(const entry& a, const entry& b)
+  {
+    return a.p.time != b.p.time ? a.p.time > b.p.time : a.arrival > b.arrival;
+  }
+
+  bool fromRun() const
+  {
+    return heap.empty() || (!run.empty() && later(heap.front(), run.front()));
+  }
+
+  const entry& oldest() const
+  {
+    return fromRun() ? run.front() : heap.front();
+  }
+
+  void release(std::vector<payment>& out)
+  {
+    if (fromRun()) {
+      released = run.front().p.time;
+      out.push_back(run.front().p);
+      run.pop_front();
+    } else {
+      std::pop_heap(heap.begin(), heap.end(), later);
+      released = heap.back().p.time;
+      out.push_back(heap.back().p);
+      heap.pop_back();
+    }
+  }
+
+  timestamp lateness;
+  timestamp newestSeen;
+  // time of the last payment released
+  timestamp released;
+  boost::uint64_t arrivals;
+  // arrived in order, oldest first
+  std::deque<entry> run;
+  std::vector<entry> heap;
+};
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/*------------------------------------------------------------------------------
+  A bounded, lock-free single-producer single-consumer queue: one thread
+  pushes, one other thread pops, and nothing else touches it.
+
+  The head and tail counters only ever grow, and each side reads the
+  other's with acquire ordering only when its own cached copy says the ring
+  is full (or empty), so most operations don't touch the other thread's
+  cache line at all.
+
+  push() and pop() wait by yielding for a few rounds, which covers the
+  usual short stall between pipeline stages, and then sleep on a condition
+  variable until the other side makes progress, so a stage starved by slow
+  input doesn't keep a core busy. Each side flags itself before sleeping;
+  the other only takes the mutex to wake it when the flag is set, which
+  costs every successful push or pop one fence.
+  ------------------------------------------------------------------------------*/
+
+template <typename T>
+class spscRing
+{
+public:
+  // capacity is rounded up to a power of two
+  explicit spscRing(std::size_t capacity)
+    : slots(roundUp(capacity)), mask(slots.size() - 1), head(0), tailCache(0), tail(0), headCache(0),
+      pusherSleeping(false), popperSleeping(false)
+  {}
+
+  bool tryPush(const T& value)
+  {
+    if (!pushNow(value))
+      return false;
+    wake(popperSleeping);
+    return true;
+  }
+
+  bool tryPop(T& value)
+  {
+    if (!popNow(value))
+      return false;
+    wake(pusherSleeping);
+    return true;
+  }
+
+  void push(const T& value)
+  {
+    for (unsigned spins = 0; !pushNow(value); spins++) {
+      if (spins < SPINS) {
+	std::this_thread::yield();
+      } else {
+	sleepUntil(pusherSleeping, [&] { return pushNow(value); });
+	break;
+      }
+    }
+    wake(popperSleeping);
+  }
+
+  T pop()
+  {
+    T value;
+    for (unsigned spins = 0; !popNow(value); spins++) {
+      if (spins < SPINS) {
+	std::this_thread::yield();
+      } else {
+	sleepUntil(popperSleeping, [&] { return popNow(value); });
+	break;
+      }
+    }
+    wake(pusherSleeping);
+    return value;
+  }
+
+private:
+  spscRing(const spscRing&);
+  spscRing& operator = (const spscRing&);
+
+  // yields before sleeping
+  static const unsigned SPINS = 64;
+
+  bool pushNow(const T& value)
+  {
+    std::size_t t = tail.load(std::memory_order_relaxed);
+    if (t - headCache == slots.size()) {
+      headCache = head.load(std::memory_order_acquire);
+      if (t - headCache == slots.size())
+	return false;
+    }
+    slots[t & mask] = value;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool popNow(T& value)
+  {
+    std::size_t h = head.load(std::memory_order_relaxed);
+    if (h == tailCache) {
+      tailCache = tail.load(std::memory_order_acquire);
+      if (h == tailCache)
+	return false;
+    }
+    value = slots[h & mask];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // The fences pair up: either the sleeper's retry sees the other side's
+  // progress, or the other side sees the flag and wakes it. The sleeper
+  // holds the mutex from its retry until it waits, so the wakeup can't
+  // slip in between.
+  template <typename Ready>
+  void sleepUntil(std::atomic<bool>& sleeping, Ready ready)
+  {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!ready())
+      wakeup.wait(lock);
+    sleeping.store(false, std::memory_order_relaxed);
+  }
+
+  void wake(std::atomic<bool>& sleeping)
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      wakeup.notify_all();
+    }
+  }
+
+  static std::size_t roundUp(std::size_t capacity)
+  {
+    std::size_t size = 1;
+    while (size < capacity)
+      size <<= 1;
+    return size;
+  }
+
+  std::vector<T> slots;
+  const std::size_t mask;
+
+  // consumer side: what it has popped, and the last tail it saw
+  alignas(64) std::atomic<std::size_t> head;
+  std::size_t tailCache;
+  // producer side: what it has pushed, and the last head it saw
+  alignas(64) std::atomic<std::size_t> tail;
+  std::size_t headCache;
+
+  // only touched once a side has run out of spins
+  alignas(64) std::atomic<bool> pusherSleeping;
+  std::atomic<bool> popperSleeping;
+  std::mutex sleepMutex;
+  std::condition_variable wakeup;
+};
+
+#endif
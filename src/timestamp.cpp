@@ -0,0 +1,138 @@
+#include "timestamp.h"
+
+#include <cstdio>
+
+namespace {
+
+  const timestamp SECONDS_PER_DAY = 86400;
+
+  const unsigned DAYS_IN_MONTH[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+  // Days since 1970-01-01 in the proleptic Gregorian calendar, and back.
+  // http://howardhinnant.github.io/date_algorithms.html
+  inline timestamp daysFromCivil(int y, unsigned m, unsigned d)
+  {
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return static_cast<timestamp>(era) * 146097 + static_cast<timestamp>(doe) - 719468;
+  }
+
+  inline void civilFromDays(timestamp z, int& y, unsigned& m, unsigned& d)
+  {
+    z += 719468;
+    const timestamp era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int>(yoe + era * 400) + (m <= 2);
+  }
+
+  // anything that isn't '0'..'9' comes out greater than 9
+  inline unsigned digit(char c)
+  {
+    return static_cast<unsigned>(static_cast<unsigned char>(c)) - '0';
+  }
+
+  inline unsigned twoDigits(const char* p, unsigned& bad)
+  {
+    unsigned hi = digit(p[0]), lo = digit(p[1]);
+    bad |= (hi > 9) | (lo > 9);
+    return hi * 10 + lo;
+  }
+
+}
+
+
+bool parseTimestamp(boost::string_view s, timestamp& result)
+{
+  // YYYY-MM-DDTHH:MM:SS[.fffffffff]Z
+  // 0123456789012345678901
+  if (s.size() < 20 || s.size() == 21 || s.size() > 30)
+    return false;
+  const char* p = s.data();
+
+  unsigned bad = (p[4] != '-') | (p[7] != '-') | (p[10] != 'T') | (p[13] != ':') | (p[16] != ':') | (s.back() != 'Z');
+  unsigned year = twoDigits(p, bad) * 100 + twoDigits(p + 2, bad);
+  unsigned month = twoDigits(p + 5, bad);
+  unsigned day = twoDigits(p + 8, bad);
+  unsigned hour = twoDigits(p + 11, bad);
+  unsigned minute = twoDigits(p + 14, bad);
+  unsigned second = twoDigits(p + 17, bad);
+
+  unsigned leap = (year % 4 == 0) & ((year % 100 != 0) | (year % 400 == 0));
+  unsigned monthDays = month - 1 < 12 ? DAYS_IN_MONTH[month - 1] + (month == 2 ? leap : 0) : 0;
+  bad |= (day - 1 >= monthDays) | (hour > 23) | (minute > 59) | (second > 59);
+  unsigned millis = 0;
+  if (s.size() > 20) {
+    bad |= p[19] != '.';
+    // digits past the millisecond only need to be digits
+    for (std::size_t i = 20; i < s.size() - 1; i++) {
+      unsigned d = digit(p[i]);
+      bad |= d > 9;
+      if (i < 23)
+	millis = millis * 10 + d;
+    }
+    for (std::size_t i = s.size() - 1; i < 23; i++) {
+      millis *= 10;
+    }
+  }
+  if (bad)
+    return false;
+
+  timestamp seconds = daysFromCivil(year, month, day) * SECONDS_PER_DAY + hour * 3600 + minute * 60 + second;
+  result = seconds * MILLISECONDS_PER_SECOND + millis;
+  return true;
+}
+
+std::string formatTimestamp(timestamp t)
+{
+  timestamp seconds = floorTicks(t, MILLISECONDS_PER_SECOND);
+  unsigned millis = static_cast<unsigned>(t - seconds * MILLISECONDS_PER_SECOND);
+  timestamp days = floorTicks(seconds, SECONDS_PER_DAY), secs = seconds - days * SECONDS_PER_DAY;
+  int y;
+  unsigned m, d;
+  civilFromDays(days, y, m, d);
+
+  char buf[32];
+  int n = std::snprintf(buf, sizeof(buf), "%04d-%02u-%02uT%02u:%02u:%02u", y, m, d,
+			static_cast<unsigned>(secs / 3600), static_cast<unsigned>(secs / 60 % 60), static_cast<unsigned>(secs % 60));
+  if (millis != 0)
+    std::snprintf(buf + n, sizeof(buf) - n, ".%03uZ", millis);
+  else
+    std::snprintf(buf + n, sizeof(buf) - n, "Z");
+  return buf;
+}
+
+bool parseDuration(boost::string_view s, timestamp& result)
+{
+  std::size_t digits = 0;
+  timestamp count = 0;
+  // up to 12 digits, so even hours can't overflow
+  while (digits < s.size() && digits < 12 && digit(s[digits]) <= 9) {
+    count = count * 10 + digit(s[digits]);
+    digits++;
+  }
+  if (digits == 0)
+    return false;
+
+  boost::string_view unit = s.substr(digits);
+  if (count == 0 && unit.empty())
+    result = 0;
+  else if (unit == "ms")
+    result = count;
+  else if (unit == "s")
+    result = count * MILLISECONDS_PER_SECOND;
+  else if (unit == "m")
+    result = count * 60 * MILLISECONDS_PER_SECOND;
+  else if (unit == "h")
+    result = count * 3600 * MILLISECONDS_PER_SECOND;
+  else
+    return false;
+  return true;
+}
@@ -0,0 +1,37 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <boost/cstdint.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include <string>
+
+
+// milliseconds since the unix epoch
+typedef boost::int64_t timestamp;
+
+const timestamp MILLISECONDS_PER_SECOND = 1000;
+
+// Parses the fixed `%Y-%m-%dT%H:%M:%SZ` layout payments use, optionally with
+// 1 to 9 digits of fractional seconds before the Z (truncated to the
+// millisecond), and nothing else: no surrounding whitespace, no offsets, no
+// out-of-range fields (2016-02-30 is rejected, not rolled over into March).
+bool parseTimestamp(boost::string_view s, timestamp& result);
+
+// inverse of parseTimestamp, for debug output and generated streams; the
+// fraction is only written when there is one
+std::string formatTimestamp(timestamp t);
+
+// Parses a duration, a whole number with a unit: ms, s, m or h, as in
+// 500ms or 15m. Zero needs no unit. It's up to the caller to reject zero
+// where it makes no sense, as windowConfig::valid does.
+bool parseDuration(boost::string_view s, timestamp& result);
+
+// largest tick of `granularity` milliseconds starting at or before t
+inline timestamp floorTicks(timestamp t, timestamp granularity)
+{
+  timestamp q = t / granularity;
+  return q * granularity > t ? q - 1 : q;
+}
+
+#endif
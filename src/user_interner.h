@@ -0,0 +1,63 @@
+#ifndef USER_INTERNER_H
+#define USER_INTERNER_H
+
+#include <boost/cstdint.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+
+typedef boost::uint32_t user_id;
+
+/*------------------------------------------------------------------------------
+  Hands out a dense id for every user name, in order of first appearance, so
+  the graph only ever stores and compares integers. Names are kept for
+  resolving ids back in debug output.
+
+  Ids are never recycled: a user that drops out of the window keeps its id
+  for when it shows up again.
+  ------------------------------------------------------------------------------*/
+
+class userInterner
+{
+public:
+  user_id intern(boost::string_view name)
+  {
+    id_map::const_iterator found = ids.find(name);
+    if (found != ids.end())
+      return found->second;
+
+    user_id id = static_cast<user_id>(names.size());
+    // deque elements never move, so the key can view the stored name
+    names.push_back(name.to_string());
+    ids.insert(id_map::value_type(names.back(), id));
+    return id;
+  }
+
+  const std::string& name(user_id id) const
+  {
+    return names[id];
+  }
+
+  std::size_t size() const
+  {
+    return names.size();
+  }
+
+private:
+  struct Hash {
+    std::size_t operator () (boost::string_view s) const {
+      return boost::hash_range(s.begin(), s.end());
+    }
+  };
+
+  typedef std::unordered_map<boost::string_view, user_id, Hash> id_map;
+
+  id_map ids;
+  std::deque<std::string> names;
+};
+
+#endif
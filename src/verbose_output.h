@@ -0,0 +1,48 @@
+#ifndef VERBOSE_OUTPUT_H
+#define VERBOSE_OUTPUT_H
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+
+/*------------------------------------------------------------------------------
+  Debug tracing.
+
+  VERBOSE_OUTPUT(level, msg) prints msg when the runtime verbosity is at
+  least level. msg is only evaluated when it's going to be printed, so
+  building it (boost::format and friends) costs nothing otherwise. In
+  release (NDEBUG) builds it is never evaluated at all, though it still has
+  to compile.
+
+  Levels: 1 traces each payment, 2 adds every expired payment and a dump
+  of the graph after each event. Traces go to stderr, each line in one
+  write, so they stay out of medians written to stdout and don't tear when
+  parser threads trace at once. Verbosity defaults to 2, or to the value
+  of the MEDIAN_DEGREE_VERBOSITY environment variable, and 0 silences it.
+  ------------------------------------------------------------------------------*/
+
+inline int& verbosity()
+{
+  static int level = std::getenv("MEDIAN_DEGREE_VERBOSITY") ? std::atoi(std::getenv("MEDIAN_DEGREE_VERBOSITY")) : 2;
+  return level;
+}
+
+inline void verboseOutput(const std::string& msg)
+{
+  std::cerr << ("(debug) " + msg + "\n");
+}
+
+#if !defined(NDEBUG)
+#define VERBOSE_ENABLED(level) (verbosity() >= (level))
+#else
+#define VERBOSE_ENABLED(level) false
+#endif
+
+#define VERBOSE_OUTPUT(level, msg)		\
+  do {						\
+    if (VERBOSE_ENABLED(level))			\
+      verboseOutput(msg);			\
+  } while (0)
+
+#endif